@@ -0,0 +1,237 @@
+/**
+ * Headless benchmarks of the AlembicEntity loader.
+ *
+ * Usage: alembicEntityBenchmark [options] <file.abc>...
+ *   --repeat N         loads per file and configuration (default: 3)
+ *   --threads LIST     comma-separated decoding thread counts (default: 0, i.e. all cores)
+ *   --format NAME      float, compact or quantized (default: float)
+ *   --streaming        stream point clouds in chunks
+ *   --max-points N     decimate point clouds to N points
+ *   --cold             clear the archive cache before each load
+ *   --mmap             read archives from a memory mapping of the file
+ *   --kernels N        also time the conversion kernels on N values
+ *   --output FILE      write results to FILE instead of the standard output
+ *
+ * Runs without a display or GPU: the offscreen platform is used unless QT_QPA_PLATFORM is set.
+ * Results are written as JSON.
+ */
+
+#include "AlembicEntity.hpp"
+#include "ArchiveCache.hpp"
+#include "ConversionKernels.hpp"
+#include "LoadStatistics.hpp"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+using namespace abcentity;
+
+namespace
+{
+
+struct BenchmarkOptions
+{
+    QStringList files;
+    int repeat = 3;
+    QList<int> threadCounts{0};
+    AlembicEntity::VertexFormat format = AlembicEntity::Float;
+    bool streaming = false;
+    int maxPoints = 0;
+    bool cold = false;
+    bool memoryMapped = false;
+    std::size_t kernelValues = 0;
+    QString output;
+};
+
+bool parseArguments(const QStringList& arguments, BenchmarkOptions& options)
+{
+    for(int i = 1; i < arguments.size(); ++i)
+    {
+        const QString& arg = arguments[i];
+        const QString value = i + 1 < arguments.size() ? arguments[i + 1] : QString();
+        if(arg == "--streaming")
+            options.streaming = true;
+        else if(arg == "--cold")
+            options.cold = true;
+        else if(arg == "--mmap")
+            options.memoryMapped = true;
+        else if(!arg.startsWith("--"))
+            options.files.append(arg);
+        else if(value.isEmpty())
+            return false;
+        else
+        {
+            ++i;
+            if(arg == "--repeat")
+                options.repeat = std::max(value.toInt(), 1);
+            else if(arg == "--max-points")
+                options.maxPoints = value.toInt();
+            else if(arg == "--kernels")
+                options.kernelValues = value.toULongLong();
+            else if(arg == "--output")
+                options.output = value;
+            else if(arg == "--threads")
+            {
+                options.threadCounts.clear();
+                for(const QString& count : value.split(','))
+                    options.threadCounts.append(count.toInt());
+            }
+            else if(arg == "--format")
+            {
+                if(value == "float")
+                    options.format = AlembicEntity::Float;
+                else if(value == "compact")
+                    options.format = AlembicEntity::Compact;
+                else if(value == "quantized")
+                    options.format = AlembicEntity::Quantized;
+                else
+                    return false;
+            }
+            else
+                return false;
+        }
+    }
+    return !options.files.isEmpty() || options.kernelValues > 0;
+}
+
+/// Load a file with a new entity and wait for the end of the load
+QJsonObject benchmarkLoad(const QString& file, int threadCount, const BenchmarkOptions& options)
+{
+    AlembicEntity entity;
+    entity.setProperty("threadCount", threadCount);
+    entity.setProperty("streaming", options.streaming);
+    entity.setProperty("maxPoints", options.maxPoints);
+    entity.setProperty("vertexFormat", options.format);
+    entity.setProperty("memoryMapped", options.memoryMapped);
+
+    QEventLoop loop;
+    QObject::connect(&entity, &AlembicEntity::statusChanged, &loop, [&loop](AlembicEntity::Status status) {
+        if(status != AlembicEntity::Loading)
+            loop.quit();
+    });
+    QElapsedTimer timer;
+    timer.start();
+    entity.setSource(QUrl::fromLocalFile(file));
+    if(entity.status() == AlembicEntity::Loading)
+        loop.exec();
+    const qint64 duration = timer.nsecsElapsed();
+
+    QJsonObject result;
+    result["file"] = file;
+    result["threadCount"] = threadCount;
+    result["status"] = entity.status() == AlembicEntity::Ready ? "ready" : "error";
+    result["durationMs"] = static_cast<double>(duration) / 1e6;
+    result["ioDurationMs"] = entity.ioDuration();
+    result["instantiationDurationMs"] = entity.instantiationDuration();
+    result["loadedPointCount"] = entity.loadedPointCount();
+    result["sourcePointCount"] = entity.sourcePointCount();
+    result["statistics"] = QJsonObject::fromVariantMap(entity.loadStatistics());
+    result["peakResidentMemory"] = static_cast<double>(LoadStatistics::peakResidentMemory());
+    return result;
+}
+
+/// Throughput of the conversion kernels, in values per second
+QJsonObject benchmarkKernels(std::size_t count)
+{
+    std::vector<uint16_t> halves(count, 0x3c00);
+    std::vector<uint8_t> bytes(count, 128);
+    std::vector<float> floats(count, 0.5f);
+    std::vector<float> output(count);
+    std::vector<uint8_t> outputBytes(count);
+    float minCorner[3], maxCorner[3];
+
+    const auto measure = [count](const std::function<void()>& kernel) {
+        QElapsedTimer timer;
+        timer.start();
+        kernel();
+        const double seconds = std::max(static_cast<double>(timer.nsecsElapsed()) / 1e9, 1e-9);
+        return static_cast<double>(count) / seconds;
+    };
+
+    QJsonObject result;
+    result["instructionSet"] = kernels::instructionSet();
+    result["values"] = static_cast<double>(count);
+    result["halfToFloat"] = measure([&] { kernels::halfToFloat(halves.data(), output.data(), count); });
+    result["unorm8ToFloat"] = measure([&] { kernels::unorm8ToFloat(bytes.data(), output.data(), count); });
+    result["floatToUnorm8"] = measure([&] { kernels::floatToUnorm8(floats.data(), outputBytes.data(), count); });
+    result["fill"] = measure([&] { kernels::fill(output.data(), count, 0.8f); });
+    result["bounds"] = measure([&] { kernels::bounds(floats.data(), count / 3, minCorner, maxCorner); });
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    // no display nor GPU needed: entities are created without a renderer
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    BenchmarkOptions options;
+    if(!parseArguments(app.arguments(), options))
+    {
+        std::cerr << "Usage: alembicEntityBenchmark [--repeat N] [--threads LIST] [--format float|compact|quantized]"
+                     " [--streaming] [--max-points N] [--cold] [--mmap] [--kernels N] [--output FILE] <file.abc>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    QJsonArray loads;
+    for(const QString& file : options.files)
+    {
+        for(int threadCount : options.threadCounts)
+        {
+            for(int i = 0; i < options.repeat; ++i)
+            {
+                if(options.cold)
+                    ArchiveCache::instance().clear();
+                QJsonObject result = benchmarkLoad(file, threadCount, options);
+                result["iteration"] = i;
+                std::cerr << qPrintable(file) << " threads=" << threadCount << " #" << i << ": "
+                          << result["durationMs"].toDouble() << " ms" << std::endl;
+                loads.append(result);
+            }
+        }
+    }
+
+    QJsonObject results;
+    results["idealThreadCount"] = QThread::idealThreadCount();
+    results["instructionSet"] = kernels::instructionSet();
+    results["format"] = static_cast<int>(options.format);
+    results["streaming"] = options.streaming;
+    results["maxPoints"] = options.maxPoints;
+    results["cold"] = options.cold;
+    results["memoryMapped"] = options.memoryMapped;
+    results["loads"] = loads;
+    if(options.kernelValues > 0)
+        results["kernels"] = benchmarkKernels(options.kernelValues);
+    results["peakResidentMemory"] = static_cast<double>(LoadStatistics::peakResidentMemory());
+
+    const QByteArray json = QJsonDocument(results).toJson();
+    if(options.output.isEmpty())
+    {
+        std::cout << json.constData();
+        return EXIT_SUCCESS;
+    }
+    QFile file(options.output);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) < 0)
+    {
+        std::cerr << "Failed to write " << qPrintable(options.output) << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
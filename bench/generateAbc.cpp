@@ -0,0 +1,180 @@
+/**
+ * Generate a synthetic Alembic archive for benchmarking.
+ *
+ * The archive mimics a reconstruction result: point clouds with colors under a
+ * hierarchy of transforms, and cameras with their own transform.
+ *
+ * Usage: alembicEntityGenerateAbc <output.abc> [--points N] [--clouds N] [--cameras N]
+ *        [--depth N] [--properties N] [--frames N] [--seed N]
+ */
+
+#include <Alembic/AbcCoreOgawa/All.h>
+#include <Alembic/AbcGeom/All.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Alembic::AbcGeom;
+
+namespace
+{
+
+struct GeneratorOptions
+{
+    std::string output;
+    /// Points per point cloud
+    std::size_t points = 1000000;
+    int clouds = 1;
+    int cameras = 100;
+    /// Number of nested transforms above each point cloud
+    int depth = 1;
+    /// User properties per object
+    int properties = 0;
+    /// Number of samples of animated transforms (1 for a static scene)
+    int frames = 1;
+    unsigned int seed = 0;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: alembicEntityGenerateAbc <output.abc> [--points N] [--clouds N] [--cameras N]"
+                 " [--depth N] [--properties N] [--frames N] [--seed N]" << std::endl;
+}
+
+bool parseArguments(int argc, char** argv, GeneratorOptions& options)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if(arg.compare(0, 2, "--") != 0)
+        {
+            options.output = arg;
+            continue;
+        }
+        if(!hasValue)
+            return false;
+        const long long value = std::atoll(argv[++i]);
+        if(value < 0)
+            return false;
+        if(arg == "--points")
+            options.points = static_cast<std::size_t>(value);
+        else if(arg == "--clouds")
+            options.clouds = static_cast<int>(value);
+        else if(arg == "--cameras")
+            options.cameras = static_cast<int>(value);
+        else if(arg == "--depth")
+            options.depth = static_cast<int>(value);
+        else if(arg == "--properties")
+            options.properties = static_cast<int>(value);
+        else if(arg == "--frames")
+            options.frames = std::max(static_cast<int>(value), 1);
+        else if(arg == "--seed")
+            options.seed = static_cast<unsigned int>(value);
+        else
+            return false;
+    }
+    return !options.output.empty();
+}
+
+void addUserProperties(OCompoundProperty userProperties, int count)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        if(i % 2 == 0)
+            OFloatProperty(userProperties, "float_" + std::to_string(i)).set(static_cast<float>(i));
+        else
+            OStringProperty(userProperties, "string_" + std::to_string(i)).set("value_" + std::to_string(i));
+    }
+}
+
+/// Write the samples of a transform, animated around its rest position if there are several frames
+void setXformSamples(OXform& xform, const V3d& translation, int frames)
+{
+    for(int frame = 0; frame < frames; ++frame)
+    {
+        XformSample sample;
+        const double angle = frames > 1 ? 0.05 * frame : 0.0;
+        sample.setTranslation(translation + V3d(std::sin(angle), 0.0, std::cos(angle) - 1.0));
+        sample.setYRotation(angle * 10.0);
+        xform.getSchema().set(sample);
+    }
+}
+
+/// Points on noisy spheres, as found on reconstructed surfaces
+void writePointCloud(OObject parent, const std::string& name, const GeneratorOptions& options, std::mt19937& rng)
+{
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<V3f> positions(options.points);
+    std::vector<C3f> colors(options.points);
+    std::vector<uint64_t> ids(options.points);
+    const int blobs = 8;
+    for(std::size_t i = 0; i < options.points; ++i)
+    {
+        const int blob = static_cast<int>(i % blobs);
+        const V3f center(static_cast<float>(blob % 4) * 4.0f, static_cast<float>(blob / 4) * 4.0f, 0.0f);
+        V3f direction(gaussian(rng), gaussian(rng), gaussian(rng));
+        direction.normalize();
+        const float radius = 1.0f + 0.02f * gaussian(rng);
+        positions[i] = center + direction * radius;
+        colors[i] = C3f(uniform(rng), uniform(rng), uniform(rng));
+        ids[i] = i;
+    }
+
+    OPoints points(parent, name);
+    OPointsSchema& schema = points.getSchema();
+    schema.set(OPointsSchema::Sample(V3fArraySample(positions), UInt64ArraySample(ids)));
+    // typed color arrays are tagged with the "rgb" interpretation
+    OC3fArrayProperty colorProperty(schema.getArbGeomParams(), "color");
+    colorProperty.set(C3fArraySample(colors));
+    addUserProperties(schema.getUserProperties(), options.properties);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    GeneratorOptions options;
+    if(!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(options.seed);
+    OArchive archive(Alembic::AbcCoreOgawa::WriteArchive(), options.output);
+    const uint32_t timeSampling = archive.addTimeSampling(TimeSampling(1.0 / 24.0, 0.0));
+
+    // point clouds under a chain of transforms
+    OObject parent = archive.getTop();
+    for(int level = 0; level < options.depth; ++level)
+    {
+        OXform xform(parent, "group_" + std::to_string(level), timeSampling);
+        setXformSamples(xform, V3d(0.0, 0.0, level == 0 ? 0.0 : 0.1), level == 0 ? options.frames : 1);
+        addUserProperties(xform.getSchema().getUserProperties(), options.properties);
+        parent = xform;
+    }
+    for(int i = 0; i < options.clouds; ++i)
+        writePointCloud(parent, "points_" + std::to_string(i), options, rng);
+
+    // cameras on a circle around the clouds
+    OXform cameras(archive.getTop(), "cameras");
+    for(int i = 0; i < options.cameras; ++i)
+    {
+        const double angle = 2.0 * 3.14159265358979323846 * i / std::max(options.cameras, 1);
+        OXform cameraXform(cameras, "camera_" + std::to_string(i), timeSampling);
+        setXformSamples(cameraXform, V3d(10.0 * std::cos(angle), 2.0, 10.0 * std::sin(angle)), 1);
+        OCamera camera(cameraXform, "camera");
+        camera.getSchema().set(CameraSample());
+        addUserProperties(camera.getSchema().getUserProperties(), options.properties);
+    }
+
+    std::cout << "Generated " << options.output << std::endl;
+    return EXIT_SUCCESS;
+}
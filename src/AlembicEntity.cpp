@@ -1,29 +1,93 @@
 #include "AlembicEntity.hpp"
+#include "ArchiveCache.hpp"
 #include "IOThread.hpp"
+#include "LoadQueue.hpp"
+#include "LoadStatistics.hpp"
+#include "CameraBatchEntity.hpp"
 #include "CameraLocatorEntity.hpp"
+#include "MeshEntity.hpp"
 #include "PointCloudEntity.hpp"
-#include <Qt3DRender/QEffect>
-#include <Qt3DRender/QTechnique>
-#include <Qt3DRender/QRenderPass>
-#include <Qt3DRender/QShaderProgram>
+#include "SampleThread.hpp"
+#include "SceneAnimation.hpp"
+#include "SceneMaterials.hpp"
 #include <Qt3DRender/QObjectPicker>
 #include <Qt3DRender/QPickEvent>
-#include <Qt3DExtras/QPerVertexColorMaterial>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QDateTime>
 #include <QFile>
-
-using namespace Alembic::Abc;
-using namespace Alembic::AbcGeom;
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QTimer>
 
 namespace abcentity
 {
 
+namespace
+{
+
+/// Whether the subtree rooted at node contains point clouds or meshes
+bool hasGeometry(const SceneNode& node)
+{
+    if(node.type == SceneNode::Type::Points || node.type == SceneNode::Type::Mesh)
+        return true;
+    for(const auto& child : node.children)
+    {
+        if(hasGeometry(*child))
+            return true;
+    }
+    return false;
+}
+
+/// Whether entity has been created for an object of the given type
+bool hasType(const BaseAlembicObject* entity, SceneNode::Type type)
+{
+    switch(type)
+    {
+    case SceneNode::Type::Points:
+        return qobject_cast<const PointCloudEntity*>(entity) != nullptr;
+    case SceneNode::Type::Camera:
+        return qobject_cast<const CameraLocatorEntity*>(entity) != nullptr;
+    case SceneNode::Type::Mesh:
+        return qobject_cast<const MeshEntity*>(entity) != nullptr;
+    default:
+        return entity->metaObject() == &BaseAlembicObject::staticMetaObject;
+    }
+}
+
+/// Modification time and size of a file, empty if it does not exist
+QString fileStamp(const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    if(!info.exists())
+        return QString();
+    return QString("%1|%2").arg(info.lastModified().toMSecsSinceEpoch()).arg(info.size());
+}
+
+} // namespace
+
 AlembicEntity::AlembicEntity(Qt3DCore::QNode* parent)
+    : AlembicEntity(nullptr, nullptr, parent)
+{
+}
+
+AlembicEntity::AlembicEntity(SceneMaterials* materials, LoadQueue* loadQueue, Qt3DCore::QNode* parent)
     : Qt3DCore::QEntity(parent)
-    , _pointSizeParameter(new Qt3DRender::QParameter)
+    , _memoryMapped(qgetenv("ALEMBICENTITY_READ_MODE") == "mmap")
+    , _materials(materials)
+    , _loadQueue(loadQueue)
     , _ioThread(new IOThread())
+    , _sampleThread(new SampleThread())
 {
+    connect(_ioThread.get(), &IOThread::sceneReady, this, &AlembicEntity::onIOThreadSceneReady);
+    connect(_ioThread.get(), &IOThread::chunksAvailable, this, &AlembicEntity::onIOThreadChunksAvailable);
     connect(_ioThread.get(), &IOThread::finished, this, &AlembicEntity::onIOThreadFinished);
-    createMaterials();
+    connect(_sampleThread.get(), &SampleThread::sampleReady, this, &AlembicEntity::onSampleThreadSampleReady);
+    if(!_materials)
+        _materials = new SceneMaterials(this);
+    connect(_materials, &SceneMaterials::pointSizeChanged, this, &AlembicEntity::onMaterialsPointSizeChanged);
+    connect(_materials, &SceneMaterials::pointStyleChanged, this, &AlembicEntity::pointStyleChanged);
 }
 
 void AlembicEntity::setSource(const QUrl& value)
@@ -32,19 +96,102 @@ void AlembicEntity::setSource(const QUrl& value)
         return;
     _source = value;
     loadAbcArchive();
+    updateWatcher();
     Q_EMIT sourceChanged();
 }
 
-void AlembicEntity::setPointSize(const float& value)
+void AlembicEntity::setWatch(bool value)
+{
+    if(_watch == value)
+        return;
+    _watch = value;
+    updateWatcher();
+    Q_EMIT watchChanged();
+}
+
+// private
+void AlembicEntity::updateWatcher()
+{
+    delete _watcher;
+    _watcher = nullptr;
+    if(!_watch || _source.isEmpty())
+    {
+        if(_watchTimer)
+            _watchTimer->stop();
+        return;
+    }
+    if(!_watchTimer)
+    {
+        _watchTimer = new QTimer(this);
+        _watchTimer->setSingleShot(true);
+        _watchTimer->setInterval(500);
+        connect(_watchTimer, &QTimer::timeout, this, &AlembicEntity::reloadIfChanged);
+    }
+    _watcher = new QFileSystemWatcher(this);
+    // files replaced by a rename are no longer watched: also watch their directory
+    const QFileInfo info(_source.toLocalFile());
+    _watcher->addPath(info.absolutePath());
+    if(info.exists())
+        _watcher->addPath(info.absoluteFilePath());
+    const auto onChanged = [this]() { _watchTimer->start(); };
+    connect(_watcher, &QFileSystemWatcher::fileChanged, this, onChanged);
+    connect(_watcher, &QFileSystemWatcher::directoryChanged, this, onChanged);
+}
+
+// private
+void AlembicEntity::reloadIfChanged()
 {
-    if(_pointSize == value)
+    if(!_watcher)
+        return;
+    const QString filePath = QFileInfo(_source.toLocalFile()).absoluteFilePath();
+    const QString stamp = fileStamp(filePath);
+    // the file is being replaced, or another file of the directory has changed
+    if(stamp.isEmpty() || stamp == _sourceStamp)
         return;
-    _pointSize = value;
-    _pointSizeParameter->setValue(value);
-    _cloudMaterial->setEnabled(_pointSize > 0.0f);
+    if(!_watcher->files().contains(filePath))
+        _watcher->addPath(filePath);
+    loadAbcArchive(true);
+}
+
+float AlembicEntity::progress() const
+{
+    if(_totalPointCount <= 0)
+        return _status == AlembicEntity::Ready ? 1.0f : 0.0f;
+    return static_cast<float>(_loadedPointCount) / static_cast<float>(_totalPointCount);
+}
+
+float AlembicEntity::pointSize() const
+{
+    return _materials->pointSize();
+}
+
+void AlembicEntity::setPointSize(const float& value)
+{
+    _materials->setPointSize(value);
+}
+
+// private
+void AlembicEntity::onMaterialsPointSizeChanged()
+{
+    // point clouds may use their own material sharing the cloud effect
+    for(auto* material : findChildren<Qt3DRender::QMaterial*>())
+    {
+        if(material->effect() == _materials->cloudEffect())
+            material->setEnabled(_materials->pointSize() > 0.0f);
+    }
     Q_EMIT pointSizeChanged();
 }
 
+AlembicEntity::PointStyle AlembicEntity::pointStyle() const
+{
+    return static_cast<PointStyle>(_materials->pointStyle());
+}
+
+void AlembicEntity::setPointStyle(PointStyle value)
+{
+    _materials->setPointStyle(static_cast<abcentity::PointStyle>(value));
+}
+
 void AlembicEntity::setLocatorScale(const float& value)
 {
     if(_locatorScale == value)
@@ -54,8 +201,143 @@ void AlembicEntity::setLocatorScale(const float& value)
     Q_EMIT locatorScaleChanged();
 }
 
+void AlembicEntity::setTime(double value)
+{
+    if(_time == value)
+        return;
+    _time = value;
+    if(_animation)
+    {
+        // apply cached samples immediately, read others in the background
+        std::shared_ptr<const SceneSample> sample = _animation->cachedSample(_time);
+        if(sample)
+            applySample(sample);
+        _sampleThread->request(_time, _prefetchFrames);
+    }
+    Q_EMIT timeChanged();
+}
+
+int AlembicEntity::frame() const
+{
+    return qRound(_time * frameRate());
+}
+
+void AlembicEntity::setFrame(int value)
+{
+    setTime(value / frameRate());
+}
+
+double AlembicEntity::startTime() const
+{
+    return _animation ? _animation->startTime() : 0.0;
+}
+
+double AlembicEntity::endTime() const
+{
+    return _animation ? _animation->endTime() : 0.0;
+}
+
+double AlembicEntity::frameRate() const
+{
+    return _animation ? _animation->frameRate() : 24.0;
+}
+
+void AlembicEntity::setSampleCacheSize(int value)
+{
+    if(_sampleCacheSize == value)
+        return;
+    _sampleCacheSize = value;
+    if(_animation)
+        _animation->setCacheSize(static_cast<std::size_t>(std::max(_sampleCacheSize, 0)) * 1024 * 1024);
+    Q_EMIT sampleCacheSizeChanged();
+}
+
+void AlembicEntity::setPointBudget(int value)
+{
+    if(_pointBudget == value)
+        return;
+    _pointBudget = value;
+    updateLevelOfDetail();
+    Q_EMIT pointBudgetChanged();
+}
+
+void AlembicEntity::setCamera(Qt3DRender::QCamera* camera)
+{
+    if(_camera == camera)
+        return;
+    if(_camera)
+        disconnect(_camera, nullptr, this, nullptr);
+    _camera = camera;
+    if(_camera)
+    {
+        connect(_camera, &Qt3DRender::QCamera::viewMatrixChanged, this, &AlembicEntity::updateLevelOfDetail);
+        connect(_camera, &Qt3DRender::QCamera::projectionMatrixChanged, this, &AlembicEntity::updateLevelOfDetail);
+        connect(_camera, &QObject::destroyed, this, [this]() { setCamera(nullptr); });
+    }
+    updateLevelOfDetail();
+    Q_EMIT cameraChanged();
+}
+
+void AlembicEntity::updateLevelOfDetail()
+{
+    qint64 totalPointCount = 0;
+    for(auto* pointCloud : _pointClouds)
+    {
+        if(pointCloud->hasLevelOfDetail())
+            totalPointCount += pointCloud->pointCount();
+    }
+    if(totalPointCount == 0)
+        return;
+    for(auto* pointCloud : _pointClouds)
+    {
+        if(!pointCloud->hasLevelOfDetail())
+            continue;
+        // share the budget proportionally to the size of each point cloud, the root node of each one being
+        // always rendered; without budget, all nodes are rendered
+        qint64 budget = 0;
+        if(_pointBudget > 0)
+            budget = std::max<qint64>(static_cast<qint64>(_pointBudget) * pointCloud->pointCount() / totalPointCount, 1);
+        pointCloud->updateLevelOfDetail(_camera, static_cast<int>(budget));
+    }
+}
+
+int AlembicEntity::pickCamera(const QVector3D& origin, const QVector3D& direction) const
+{
+    return _cameraBatch ? _cameraBatch->pickCamera(origin, direction) : -1;
+}
+
+QVariantMap AlembicEntity::pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const
+{
+    QVariantMap picked;
+    for(auto* pointCloud : _pointClouds)
+    {
+        if(!pointCloud->isEnabled())
+            continue;
+        QVariantMap result = pointCloud->pickPoint(origin, direction, radius);
+        if(result.isEmpty() ||
+           (!picked.isEmpty() && result.value("distance").toFloat() >= picked.value("distance").toFloat()))
+            continue;
+        result.insert(QStringLiteral("pointCloud"), QVariant::fromValue(pointCloud));
+        result.insert(QStringLiteral("path"), pointCloud->path());
+        picked = result;
+    }
+    return picked;
+}
+
+void AlembicEntity::cancelLoad()
+{
+    _ioThread->cancel();
+    _ioThread->wait();
+    if(_loadQueue)
+        _loadQueue->release(this);
+    if(_status == AlembicEntity::Loading)
+        setStatus(AlembicEntity::None);
+}
+
 void AlembicEntity::scaleLocators() const
 {
+    if(_cameraBatch)
+        _cameraBatch->setLocatorScale(_locatorScale);
     for(auto* entity : _cameras)
     {
         for(auto* transform : entity->findChildren<Qt3DCore::QTransform*>())
@@ -63,57 +345,15 @@ void AlembicEntity::scaleLocators() const
     }
 }
 
-// private
-void AlembicEntity::createMaterials()
-{
-    using namespace Qt3DRender;
-    using namespace Qt3DExtras;
-
-    _cloudMaterial = new QMaterial(this);
-    _cameraMaterial = new QPerVertexColorMaterial(this);
-
-    // configure cloud material
-    auto effect = new QEffect;
-    auto technique = new QTechnique;
-    auto renderPass = new QRenderPass;
-    auto shaderProgram = new QShaderProgram;
-
-    shaderProgram->setVertexShaderCode(R"(#version 130
-    in vec3 vertexPosition;
-    in vec3 vertexColor;
-    out vec3 color;
-    uniform mat4 mvp;
-    uniform mat4 projectionMatrix;
-    uniform mat4 viewportMatrix;
-    uniform float pointSize;
-    void main()
-    {
-        color = vertexColor;
-        gl_Position = mvp * vec4(vertexPosition, 1.0);
-        gl_PointSize = max(viewportMatrix[1][1] * projectionMatrix[1][1] * pointSize / gl_Position.w, 1.0);
-    }
-    )");
-
-    // set fragment shader
-    shaderProgram->setFragmentShaderCode(R"(#version 130
-        in vec3 color;
-        out vec4 fragColor;
-        void main(void)
-        {
-            fragColor = vec4(color, 1.0);
-        }
-    )");
-
-    // add a pointSize uniform
-    _pointSizeParameter->setName("pointSize");
-    _pointSizeParameter->setValue(_pointSize);
-    _cloudMaterial->addParameter(_pointSizeParameter);
-
-    // build the material
-    renderPass->setShaderProgram(shaderProgram);
-    technique->addRenderPass(renderPass);
-    effect->addTechnique(technique);
-    _cloudMaterial->setEffect(effect);
+void AlembicEntity::updateLocatorGeometry()
+{
+    std::shared_ptr<const LocatorGeometry> geometry =
+        LocatorGeometry::get(static_cast<abcentity::LocatorStyle>(_locatorStyle));
+    if(geometry == _locatorGeometry)
+        return;
+    _locatorGeometry = geometry;
+    delete _locatorRenderer;
+    _locatorRenderer = _locatorGeometry->createRenderer(this);
 }
 
 void AlembicEntity::clear()
@@ -128,119 +368,483 @@ void AlembicEntity::clear()
     for(auto& component : components())
         removeComponent(component);
     _cameras.clear();
+    _cameraBatch = nullptr;
     _pointClouds.clear();
+    _meshes.clear();
+    _streamedPointClouds.clear();
+    _transforms.clear();
+    _sampleThread->setAnimation(nullptr);
+    _animation.reset();
+    _currentSample.reset();
+    _animatedEntities.clear();
+    _digests.clear();
+    _loadedPointCount = 0;
+    _totalPointCount = 0;
+    _sourcePointCount = 0;
+    Q_EMIT loadedPointCountChanged();
+    updateBoundingBox();
+}
+
+QVariantMap AlembicEntity::archiveCacheStatistics() const
+{
+    const ArchiveCache::Statistics statistics = ArchiveCache::instance().statistics();
+    QVariantMap map;
+    map["archiveHits"] = static_cast<qulonglong>(statistics.archiveHits);
+    map["archiveMisses"] = static_cast<qulonglong>(statistics.archiveMisses);
+    map["pointCloudHits"] = static_cast<qulonglong>(statistics.pointCloudHits);
+    map["pointCloudMisses"] = static_cast<qulonglong>(statistics.pointCloudMisses);
+    map["archiveCount"] = static_cast<qulonglong>(statistics.archiveCount);
+    map["pointCloudBytes"] = static_cast<qulonglong>(statistics.pointCloudBytes);
+    return map;
+}
+
+QVariantMap AlembicEntity::loadStatistics() const
+{
+    return _loadStatistics ? _loadStatistics->toVariantMap() : QVariantMap();
+}
+
+void AlembicEntity::clearArchiveCache()
+{
+    ArchiveCache::instance().clear();
 }
 
 // private
-void AlembicEntity::loadAbcArchive()
+void AlembicEntity::loadAbcArchive(bool incremental)
 {
-    clear();
+    _incremental = incremental;
+    if(!_incremental)
+        clear();
     if(_source.isEmpty())
     {
+        _ioThread->cancel();
+        if(_loadQueue)
+            _loadQueue->release(this);
         setStatus(AlembicEntity::None);
         return;
     }
+    _sourceStamp = fileStamp(_source.toLocalFile());
     setStatus(AlembicEntity::Loading);
-    _ioThread->read(_source);
+    _loadStatistics = std::make_shared<LoadStatistics>();
+    LoadOptions options;
+    options.statistics = _loadStatistics;
+    options.skipHidden = _skipHidden;
+    options.streaming = _streaming;
+    options.chunkSize = _chunkSize;
+    options.threadCount = _threadCount;
+    options.maxPoints = _maxPoints;
+    options.memoryMapped = _memoryMapped;
+    options.levelOfDetail = _pointBudget > 0;
+    options.vertexFormat = static_cast<abcentity::VertexFormat>(_vertexFormat);
+    options.pointRadii = _adaptivePointSize;
+    options.pickingTree = _pointPicking;
+    options.flattenHierarchy = _flattenHierarchy;
+    options.time = _time;
+    options.watch = _watch;
+    // point clouds of the displayed scene are not read again if unchanged
+    if(_incremental)
+        options.previousDigests = _digests;
+    _loadTime = _time;
+    if(!_loadQueue)
+    {
+        _ioThread->read(_source, options);
+        return;
+    }
+    // discard the results of the current load while waiting for a free slot
+    _ioThread->cancel();
+    const QUrl source = _source;
+    _loadQueue->request(this, [this, source, options]() { _ioThread->read(source, options); });
 }
 
-void AlembicEntity::onIOThreadFinished()
+void AlembicEntity::onIOThreadSceneReady()
 {
-    const auto& archive = _ioThread->archive();
-    if(!archive.valid())
-    {
-        setStatus(AlembicEntity::Error);
+    std::unique_ptr<SceneNode> scene = _ioThread->takeScene();
+    if(!scene)
         return;
+    if(_incremental)
+    {
+        // counts and animation are rebuilt from the new scene, entities are updated in place
+        _sampleThread->setAnimation(nullptr);
+        _currentSample.reset();
+        _animatedEntities.clear();
+        _streamedPointClouds.clear();
+        _loadedPointCount = 0;
+        _totalPointCount = 0;
+        _sourcePointCount = 0;
     }
-    // visit the abc tree
+    _transforms.swap(scene->transforms);
+    _animation = scene->animation;
+    // instantiate entities from the scene description
+    QElapsedTimer timer;
+    timer.start();
+    LoadStatistics::Scope scope(_loadStatistics.get(), "instantiate");
     try
     {
-        visitAbcObject(archive.getTop(), this);
+        updateLocatorGeometry();
+        if(_incremental)
+        {
+            QHash<QString, BaseAlembicObject*> entities;
+            for(auto* entity : findChildren<BaseAlembicObject*>())
+            {
+                if(entity != _cameraBatch)
+                    entities.insert(entity->path(), entity);
+            }
+            // batched cameras are cheap to gather again
+            if(_cameraBatch)
+            {
+                _cameraBatch->setParent((QNode*)nullptr);
+                _cameraBatch->deleteLater();
+                _cameraBatch = nullptr;
+            }
+            if(_batchCameras)
+                _cameraBatch = new CameraBatchEntity(_locatorGeometry, _materials->cameraBatchEffect(), this);
+            _digests.clear();
+            updateNode(*scene, this, entities);
+            // remove the entities of objects that no longer exist
+            for(auto* entity : entities)
+            {
+                entity->setParent((QNode*)nullptr);
+                entity->deleteLater();
+            }
+        }
+        else
+        {
+            if(_batchCameras)
+                _cameraBatch = new CameraBatchEntity(_locatorGeometry, _materials->cameraBatchEffect(), this);
+            instantiateNode(*scene, this);
+        }
+
+        if(_cameraBatch)
+        {
+            if(_cameraBatch->count() > 0)
+            {
+                _cameraBatch->update();
+            }
+            else
+            {
+                delete _cameraBatch;
+                _cameraBatch = nullptr;
+            }
+        }
 
         // store pointers to cameras and point clouds
         _cameras = findChildren<CameraLocatorEntity*>();
         _pointClouds = findChildren<PointCloudEntity*>();
+        _meshes = findChildren<MeshEntity*>();
+
+        if(_animation)
+        {
+            QSet<QString> paths;
+            for(const auto& track : _animation->transformTracks())
+                paths.insert(track.path);
+            for(const auto& track : _animation->pointsTracks())
+                paths.insert(track.path);
+            for(auto* entity : findChildren<BaseAlembicObject*>())
+            {
+                if(paths.contains(entity->path()))
+                    _animatedEntities.insert(entity->path(), entity);
+            }
+            _animation->setCacheSize(static_cast<std::size_t>(std::max(_sampleCacheSize, 0)) * 1024 * 1024);
+            _sampleThread->setAnimation(_animation);
+            _sampleThread->request(_time, _prefetchFrames);
+        }
 
         // perform initial locator scaling
         scaleLocators();
-
-        setStatus(AlembicEntity::Ready);
+        updateLevelOfDetail();
+        updateBoundingBox();
     }
     catch(...)
     {
         clear();
-        setStatus(AlembicEntity::Error);
     }
-    _ioThread->clear();
+    _instantiationDuration = static_cast<int>(timer.elapsed());
+    Q_EMIT animationChanged();
     Q_EMIT camerasChanged();
     Q_EMIT pointCloudsChanged();
+    Q_EMIT meshesChanged();
+    Q_EMIT loadedPointCountChanged();
 }
 
-// private
-void AlembicEntity::visitAbcObject(const Alembic::Abc::IObject& iObj, QEntity* parent)
+void AlembicEntity::onIOThreadChunksAvailable()
 {
-    using namespace Alembic::Abc;
-    using namespace Alembic::AbcGeom;
+    const std::vector<PointCloudChunk> chunks = _ioThread->takeChunks();
+    if(chunks.empty())
+        return;
+    QElapsedTimer timer;
+    timer.start();
+    LoadStatistics::Scope scope(_loadStatistics.get(), "upload");
+    for(const auto& chunk : chunks)
+    {
+        PointCloudEntity* pointCloud = _streamedPointClouds.value(chunk.streamIndex, nullptr);
+        if(!pointCloud)
+            continue;
+        pointCloud->addChunk(chunk.data);
+        _loadedPointCount += chunk.data.npoints;
+        if(_loadStatistics)
+            _loadStatistics->add(LoadStatistics::Counter::PointsUploaded, chunk.data.npoints);
+    }
+    updateLevelOfDetail();
+    updateBoundingBox();
+    _instantiationDuration += static_cast<int>(timer.elapsed());
+    Q_EMIT loadedPointCountChanged();
+}
+
+void AlembicEntity::onIOThreadFinished()
+{
+    // a new request has been made since this load, is waiting for a free slot, or the load has been cancelled
+    if(_ioThread->isLoading() || (_loadQueue && _loadQueue->isQueued(this)) || _status != AlembicEntity::Loading)
+        return;
+    if(_loadQueue)
+        _loadQueue->release(this);
+    // upload remaining chunks
+    onIOThreadChunksAvailable();
+    _ioDuration = static_cast<int>(_ioThread->readDuration());
+    const bool error = _ioThread->hasError();
+    const bool failed = error || findChildren<BaseAlembicObject*>().isEmpty();
+    _ioThread->clear();
+    if(_loadStatistics)
+    {
+        _loadStatistics->finish();
+        if(!_traceFile.isEmpty() && !_loadStatistics->writeChromeTrace(_traceFile.toLocalFile()))
+            qWarning() << "[AlembicEntity] Failed to write trace file" << _traceFile.toLocalFile();
+    }
+    if(error && _incremental)
+    {
+        // the file may still be being written: keep the current scene until its next change
+        setStatus(AlembicEntity::Ready);
+        return;
+    }
+    if(failed)
+    {
+        clear();
+        setStatus(AlembicEntity::Error);
+        Q_EMIT camerasChanged();
+        Q_EMIT pointCloudsChanged();
+        Q_EMIT meshesChanged();
+        return;
+    }
+    setStatus(AlembicEntity::Ready);
+    Q_EMIT loadedPointCountChanged();
+}
 
-    const auto createEntity = [&](const IObject&) -> BaseAlembicObject* {
-        const MetaData& md = iObj.getMetaData();
+void AlembicEntity::onSampleThreadSampleReady()
+{
+    std::shared_ptr<const SceneSample> sample = _sampleThread->takeSample();
+    // ignore samples of previous requests or already applied
+    if(!sample || !_animation || qAbs(sample->time - _time) > 1e-6 || sample == _currentSample)
+        return;
+    // the loaded scene is already at this time
+    if(!_currentSample && qAbs(sample->time - _loadTime) <= 1e-6)
+    {
+        _currentSample = sample;
+        return;
+    }
+    applySample(sample);
+}
 
-        if(IPoints::matches(md))
-        {
-            IPoints points(iObj, Alembic::Abc::kWrapExisting);
-            PointCloudEntity* entity = new PointCloudEntity(parent);
-            entity->setData(iObj);
-            entity->addComponent(_cloudMaterial);
-            entity->fillArbProperties(points.getSchema().getArbGeomParams());
-            entity->fillUserProperties(points.getSchema().getUserProperties());
-            return entity;
-        }
-        else if(IXform::matches(md))
+// private
+void AlembicEntity::applySample(const std::shared_ptr<const SceneSample>& sample)
+{
+    using TransformTrack = SceneAnimation::TransformTrack;
+
+    _currentSample = sample;
+    bool camerasMoved = false;
+    const auto& transformTracks = _animation->transformTracks();
+    for(std::size_t i = 0; i < transformTracks.size() && i < sample->matrices.size(); ++i)
+    {
+        const TransformTrack& track = transformTracks[i];
+        if(track.space == TransformTrack::Space::World)
         {
-            IXform xform(iObj, kWrapExisting);
-            BaseAlembicObject* entity = new BaseAlembicObject(parent);
-            XformSample xs;
-            xform.getSchema().get(xs);
-            entity->setTransform(xs.getMatrix());
-            entity->fillArbProperties(xform.getSchema().getArbGeomParams());
-            entity->fillUserProperties(xform.getSchema().getUserProperties());
-            return entity;
+            // world matrices are only used by batched cameras and flattened objects
+            const int cameraIndex = _cameraBatch ? _cameraBatch->cameraIndex(track.path) : -1;
+            if(cameraIndex >= 0)
+            {
+                _cameraBatch->setCameraMatrix(cameraIndex, sample->matrices[i]);
+                camerasMoved = true;
+                continue;
+            }
+            // the flattenHierarchy property may have changed since the scene was loaded
+            if(!_animation->isFlattened())
+                continue;
         }
-        else if(ICamera::matches(md))
+        BaseAlembicObject* entity = _animatedEntities.value(track.path, nullptr);
+        if(entity)
+            entity->setTransform(sample->matrices[i]);
+    }
+    if(camerasMoved)
+        _cameraBatch->update();
+
+    const auto& pointsTracks = _animation->pointsTracks();
+    for(std::size_t i = 0; i < pointsTracks.size() && i < sample->pointClouds.size(); ++i)
+    {
+        auto* pointCloud = qobject_cast<PointCloudEntity*>(_animatedEntities.value(pointsTracks[i].path, nullptr));
+        if(!pointCloud)
+            continue;
+        pointCloud->clearData();
+        pointCloud->setData(sample->pointClouds[i]);
+    }
+    scaleLocators();
+    updateLevelOfDetail();
+    updateBoundingBox();
+}
+
+// private
+void AlembicEntity::updateBoundingBox()
+{
+    // per point cloud bounds are computed on the IO thread: only transform them
+    BoundingBox box;
+    for(const auto* pointCloud : _pointClouds)
+        box.extend(pointCloud->boundingBox().transformed(pointCloud->worldMatrix(this)));
+    for(const auto* mesh : _meshes)
+        box.extend(mesh->boundingBox().transformed(mesh->worldMatrix(this)));
+    for(const auto* camera : _cameras)
+        box.extend(camera->worldMatrix(this).map(QVector3D()));
+    if(_cameraBatch)
+    {
+        const QMatrix4x4 batchMatrix = _cameraBatch->worldMatrix(this);
+        for(int i = 0; i < _cameraBatch->count(); ++i)
+            box.extend((batchMatrix * _cameraBatch->cameraMatrix(i)).map(QVector3D()));
+    }
+    if(box == _boundingBox)
+        return;
+    _boundingBox = box;
+    Q_EMIT boundingBoxChanged();
+}
+
+// private
+void AlembicEntity::instantiateNode(const SceneNode& node, QEntity* parent)
+{
+    // in batch mode, subtrees only made of cameras and transforms need no entity
+    if(_cameraBatch && !hasGeometry(node))
+    {
+        _cameraBatch->addCameras(node);
+        return;
+    }
+
+    BaseAlembicObject* entity = createEntity(node, parent);
+    updateEntity(entity, node);
+
+    // instantiate children
+    for(const auto& child : node.children)
+        instantiateNode(*child, entity);
+}
+
+// private
+void AlembicEntity::updateNode(const SceneNode& node, QEntity* parent, QHash<QString, BaseAlembicObject*>& entities)
+{
+    if(_cameraBatch && !hasGeometry(node))
+    {
+        _cameraBatch->addCameras(node);
+        return;
+    }
+
+    BaseAlembicObject* entity = entities.value(node.path, nullptr);
+    if(entity && hasType(entity, node.type))
+    {
+        entities.remove(node.path);
+        // the parent may have been created again with another type
+        if(entity->parentNode() != parent)
+            entity->setParent(parent);
+        // the locator geometry may have changed since the previous load
+        if(node.type == SceneNode::Type::Camera && !entity->components().contains(_locatorRenderer))
+            entity->addComponent(_locatorRenderer);
+    }
+    else
+    {
+        entity = createEntity(node, parent);
+    }
+    updateEntity(entity, node);
+
+    for(const auto& child : node.children)
+        updateNode(*child, entity, entities);
+}
+
+// private
+BaseAlembicObject* AlembicEntity::createEntity(const SceneNode& node, QEntity* parent)
+{
+    BaseAlembicObject* entity = nullptr;
+    switch(node.type)
+    {
+    case SceneNode::Type::Points:
+    {
+        PointCloudEntity* pointCloud = new PointCloudEntity(parent);
+        pointCloud->addComponent(_materials->cloudMaterial());
+        entity = pointCloud;
+        break;
+    }
+    case SceneNode::Type::Mesh:
+    {
+        MeshEntity* mesh = new MeshEntity(parent);
+        mesh->addComponent(_materials->meshMaterial());
+        entity = mesh;
+        break;
+    }
+    case SceneNode::Type::Camera:
+    {
+        CameraLocatorEntity* camera = new CameraLocatorEntity(parent);
+        camera->addComponent(_locatorRenderer);
+        camera->addComponent(_materials->cameraMaterial());
+        entity = camera;
+        break;
+    }
+    case SceneNode::Type::Xform:
+        entity = new BaseAlembicObject(parent);
+        break;
+    case SceneNode::Type::Unknown:
+    default:
+        // fallback: create empty object to preserve hierarchy
+        entity = new BaseAlembicObject(parent);
+        break;
+    }
+    if(_loadStatistics)
+        _loadStatistics->add(LoadStatistics::Counter::Entities, 1);
+    return entity;
+}
+
+// private
+void AlembicEntity::updateEntity(BaseAlembicObject* entity, const SceneNode& node)
+{
+    if(node.type == SceneNode::Type::Points)
+    {
+        PointCloudEntity* pointCloud = static_cast<PointCloudEntity*>(entity);
+        if(node.unchanged)
         {
-            ICamera cam(iObj, Alembic::Abc::kWrapExisting);
-            CameraLocatorEntity* entity = new CameraLocatorEntity(parent);
-            entity->addComponent(_cameraMaterial);
-            entity->fillArbProperties(cam.getSchema().getArbGeomParams());
-            entity->fillUserProperties(cam.getSchema().getUserProperties());
-            return entity;
+            // keep the data of the previous load
+            _loadedPointCount += pointCloud->pointCount();
         }
         else
         {
-            // fallback: create empty object to preserve hierarchy
-            return new BaseAlembicObject(parent);
+            // replace the data of a reused entity
+            pointCloud->clearData();
+            if(node.streamIndex >= 0)
+            {
+                _streamedPointClouds[node.streamIndex] = pointCloud;
+            }
+            else
+            {
+                pointCloud->setData(node.pointCloud);
+                _loadedPointCount += node.pointCloud.npoints;
+                if(_loadStatistics)
+                    _loadStatistics->add(LoadStatistics::Counter::PointsUploaded, node.pointCloud.npoints);
+            }
         }
-    };
-
-    if(_skipHidden)
+        _totalPointCount += node.pointCount;
+        _sourcePointCount += node.sourcePointCount;
+        if(!node.digest.isEmpty())
+            _digests.insert(node.path, node.digest);
+    }
+    else if(node.type == SceneNode::Type::Mesh)
     {
-        // Skip objects with visibilityProperty explicitly set to hidden
-        const auto& prop = iObj.getProperties();
-
-        if(prop.getPropertyHeader(kVisibilityPropertyName))
-        {
-            IVisibilityProperty visibilityProperty(prop, kVisibilityPropertyName);
-            if(ObjectVisibility(visibilityProperty.getValue()) == kVisibilityHidden)
-                return;
-        }
+        MeshEntity* mesh = static_cast<MeshEntity*>(entity);
+        // meshes are always read again: replace the data of a reused entity
+        mesh->clearData();
+        mesh->setData(node.mesh);
     }
-
-    BaseAlembicObject* entity = createEntity(iObj);
-    entity->setObjectName(iObj.getName().c_str());
-
-    // visit children
-    for(size_t i = 0; i < iObj.getNumChildren(); i++)
-        visitAbcObject(iObj.getChild(i), entity);
+    entity->setTransform(node.matrix);
+    entity->setArbProperties(node.arbProperties);
+    entity->setUserProperties(node.userProperties);
+    entity->setObjectName(node.name);
+    entity->setPath(node.path);
 }
 
 } // namespace
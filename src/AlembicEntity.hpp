@@ -2,30 +2,111 @@
 
 #include <QEntity>
 #include <QUrl>
-#include <Alembic/AbcGeom/All.h>
+#include "LocatorGeometry.hpp"
+#include "SceneDescription.hpp"
 #include <Qt3DCore/QTransform>
 #include <Qt3DRender/QParameter>
+#include <Qt3DRender/QEffect>
 #include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QCamera>
 #include <QQmlListProperty>
+#include <QHash>
+#include <QStringList>
 
+class QFileSystemWatcher;
+class QTimer;
 
 namespace abcentity
 {
+class CameraBatchEntity;
 class CameraLocatorEntity;
+class MeshEntity;
 class PointCloudEntity;
 class IOThread;
+class LoadQueue;
+class LoadStatistics;
+class SampleThread;
+class SceneAnimation;
+class SceneMaterials;
+struct SceneSample;
 
 class AlembicEntity : public Qt3DCore::QEntity
 {
     Q_OBJECT
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
     Q_PROPERTY(bool skipHidden MEMBER _skipHidden NOTIFY skipHiddenChanged)
+    /// Only create entities for point clouds and cameras, with their transforms baked on the IO thread
+    Q_PROPERTY(bool flattenHierarchy MEMBER _flattenHierarchy NOTIFY flattenHierarchyChanged)
+    /// Render all cameras with a single instanced locator instead of one entity per camera
+    Q_PROPERTY(bool batchCameras MEMBER _batchCameras NOTIFY batchCamerasChanged)
+    /// Upload point clouds progressively, in chunks of chunkSize points
+    Q_PROPERTY(bool streaming MEMBER _streaming NOTIFY streamingChanged)
+    Q_PROPERTY(int chunkSize MEMBER _chunkSize NOTIFY chunkSizeChanged)
+    /// Read archives from a memory mapping of the file instead of file streams, applied when an archive is opened.
+    /// Defaults to true if the ALEMBICENTITY_READ_MODE environment variable is "mmap".
+    Q_PROPERTY(bool memoryMapped MEMBER _memoryMapped NOTIFY memoryMappedChanged)
+    /// Reload the archive in the background when its file changes. Point clouds are matched by path and
+    /// content digest: only the entities of objects that changed, appeared or disappeared are rebuilt.
+    Q_PROPERTY(bool watch READ watch WRITE setWatch NOTIFY watchChanged)
+    /// Number of threads decoding point clouds, 0 for the number of cores
+    Q_PROPERTY(int threadCount MEMBER _threadCount NOTIFY threadCountChanged)
+    /// Maximum number of points loaded (0 for all points), applied at load time. Point clouds are decimated
+    /// on the IO thread to a spatially uniform subset, the budget being shared proportionally to their size.
+    Q_PROPERTY(int maxPoints MEMBER _maxPoints NOTIFY maxPointsChanged)
+    /// Maximum number of rendered points; if > 0, point clouds are loaded with a level-of-detail octree.
+    /// The root node of each point cloud is always rendered. Once loaded, all nodes are rendered if <= 0.
+    Q_PROPERTY(int pointBudget READ pointBudget WRITE setPointBudget NOTIFY pointBudgetChanged)
+    /// Camera used to select the octree nodes to render
+    Q_PROPERTY(Qt3DRender::QCamera* camera READ camera WRITE setCamera NOTIFY cameraChanged)
+    /// Layout of point cloud vertex buffers, applied at load time
+    Q_PROPERTY(VertexFormat vertexFormat MEMBER _vertexFormat NOTIFY vertexFormatChanged)
     Q_PROPERTY(float pointSize READ pointSize WRITE setPointSize NOTIFY pointSizeChanged)
+    /// Shape of rendered points
+    Q_PROPERTY(PointStyle pointStyle READ pointStyle WRITE setPointStyle NOTIFY pointStyleChanged)
+    /// Compute a radius for each point from the spacing of its nearest neighbours on the IO thread, applied at
+    /// load time. Points are then rendered at least as large as their radius, pointSize being the minimum size.
+    Q_PROPERTY(bool adaptivePointSize MEMBER _adaptivePointSize NOTIFY adaptivePointSizeChanged)
+    /// Build a k-d tree over each point cloud on the IO thread, applied at load time. pickPoint only picks
+    /// the points of point clouds loaded with it.
+    Q_PROPERTY(bool pointPicking MEMBER _pointPicking NOTIFY pointPickingChanged)
     Q_PROPERTY(float locatorScale READ locatorScale WRITE setLocatorScale NOTIFY locatorScaleChanged)
+    /// Shape of camera locators, applied at load time
+    Q_PROPERTY(LocatorStyle locatorStyle MEMBER _locatorStyle NOTIFY locatorStyleChanged)
     Q_PROPERTY(QQmlListProperty<abcentity::CameraLocatorEntity> cameras READ cameras NOTIFY camerasChanged)
+    /// Cameras loaded in batch mode, null otherwise
+    Q_PROPERTY(abcentity::CameraBatchEntity* cameraBatch READ cameraBatch NOTIFY camerasChanged)
     Q_PROPERTY(QQmlListProperty<abcentity::PointCloudEntity> pointClouds READ pointClouds NOTIFY pointCloudsChanged)
+    Q_PROPERTY(QQmlListProperty<abcentity::MeshEntity> meshes READ meshes NOTIFY meshesChanged)
+    /// Bounds of the point clouds, meshes and camera positions, in this entity's frame (e.g. to frame the whole scene)
+    Q_PROPERTY(abcentity::BoundingBox boundingBox READ boundingBox NOTIFY boundingBoxChanged)
+
+    /// Time at which animated objects are displayed, in seconds
+    Q_PROPERTY(double time READ time WRITE setTime NOTIFY timeChanged)
+    /// Frame at which animated objects are displayed, at frameRate
+    Q_PROPERTY(int frame READ frame WRITE setFrame NOTIFY timeChanged)
+    Q_PROPERTY(bool animated READ animated NOTIFY animationChanged)
+    Q_PROPERTY(double startTime READ startTime NOTIFY animationChanged)
+    Q_PROPERTY(double endTime READ endTime NOTIFY animationChanged)
+    Q_PROPERTY(double frameRate READ frameRate NOTIFY animationChanged)
+    /// Number of frames read ahead of the current time in the background
+    Q_PROPERTY(int prefetchFrames MEMBER _prefetchFrames NOTIFY prefetchFramesChanged)
+    /// Maximum memory used by cached animation samples, in megabytes
+    Q_PROPERTY(int sampleCacheSize READ sampleCacheSize WRITE setSampleCacheSize NOTIFY sampleCacheSizeChanged)
 
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    /// Number of points loaded so far, after decimation
+    Q_PROPERTY(int loadedPointCount READ loadedPointCount NOTIFY loadedPointCountChanged)
+    /// Number of points of the loaded point clouds in the archive, before decimation
+    Q_PROPERTY(int sourcePointCount READ sourcePointCount NOTIFY loadedPointCountChanged)
+    Q_PROPERTY(float progress READ progress NOTIFY loadedPointCountChanged)
+    /// Time spent reading the archive on the IO thread during the last load, in milliseconds
+    Q_PROPERTY(int ioDuration READ ioDuration NOTIFY statusChanged)
+    /// Time spent creating entities on the GUI thread during the last load, in milliseconds
+    Q_PROPERTY(int instantiationDuration READ instantiationDuration NOTIFY statusChanged)
+    /// Stage timings, counters and memory use of the last load (see LoadStatistics::toVariantMap)
+    Q_PROPERTY(QVariantMap loadStatistics READ loadStatistics NOTIFY statusChanged)
+    /// If set, a Chrome trace of each load is written to this file (chrome://tracing, Perfetto)
+    Q_PROPERTY(QUrl traceFile MEMBER _traceFile NOTIFY traceFileChanged)
 
 public:
     // Identical to SceneLoader.Status
@@ -37,17 +118,102 @@ public:
     };
     Q_ENUM(Status)
 
+    // Identical to abcentity::VertexFormat
+    enum VertexFormat {
+            Float = 0,  ///< float32 positions and colors in separate buffers
+            Compact,    ///< interleaved float32 positions and RGB8 colors
+            Quantized   ///< interleaved 16-bit positions and RGB8 colors
+    };
+    Q_ENUM(VertexFormat)
+
+    // Identical to abcentity::PointStyle
+    enum PointStyle {
+            Square = 0,  ///< flat square points
+            Splat        ///< round splats, depth-corrected as spheres
+    };
+    Q_ENUM(PointStyle)
+
+    // Identical to abcentity::LocatorStyle
+    enum LocatorStyle {
+            Frustum = 0,  ///< coordinate system, view frustum and up direction
+            Axis          ///< coordinate system only
+    };
+    Q_ENUM(LocatorStyle)
+
     explicit AlembicEntity(Qt3DCore::QNode* = nullptr);
+    /**
+     * @brief Create an entity rendering with shared materials, whose loads are scheduled by a shared queue.
+     * @param materials materials to use, created for this entity if null
+     * @param loadQueue queue bounding the concurrent loads, loads starting immediately if null
+     */
+    AlembicEntity(SceneMaterials* materials, LoadQueue* loadQueue, Qt3DCore::QNode* parent = nullptr);
     ~AlembicEntity() override = default;
 
     Q_SLOT const QUrl& source() const { return _source; }
-    Q_SLOT float pointSize() const { return _pointSize; }
+    Q_SLOT float pointSize() const;
     Q_SLOT float locatorScale() const { return _locatorScale; }
     Q_SLOT void setSource(const QUrl& source);
     Q_SLOT void setPointSize(const float& value);
     Q_SLOT void setLocatorScale(const float& value);
 
+    /// Point size and style are those of the materials, shared by the archives of a group
+    PointStyle pointStyle() const;
+    void setPointStyle(PointStyle value);
+
+    bool watch() const { return _watch; }
+    void setWatch(bool value);
+    int pointBudget() const { return _pointBudget; }
+    void setPointBudget(int value);
+    Qt3DRender::QCamera* camera() const { return _camera; }
+    void setCamera(Qt3DRender::QCamera* camera);
+
+    CameraBatchEntity* cameraBatch() const { return _cameraBatch; }
+    const BoundingBox& boundingBox() const { return _boundingBox; }
+    /// Index of the batched camera hit by a ray in world coordinates, -1 if none
+    Q_INVOKABLE int pickCamera(const QVector3D& origin, const QVector3D& direction) const;
+    /**
+     * @brief Pick the first point along a ray in world coordinates, among the points of the enabled
+     * point clouds closer than radius to it (requires pointPicking).
+     * @return the result of PointCloudEntity::pickPoint with the "pointCloud" entity and its "path",
+     * or an empty map if no point is picked
+     */
+    Q_INVOKABLE QVariantMap pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const;
+
+    /// Cancel the running or queued load and wait for the IO thread to stop; the loaded objects are kept
+    void cancelLoad();
+
+    /// Full paths of all the objects of the archive, including those not instantiated
+    Q_INVOKABLE QStringList objectPaths() const { return _transforms.keys(); }
+    /// Full path of the parent of an object, empty for the root or unknown objects
+    Q_INVOKABLE QString objectParent(const QString& path) const { return _transforms.value(path).parentPath; }
+    /// Local transform of an object
+    Q_INVOKABLE QMatrix4x4 objectMatrix(const QString& path) const { return _transforms.value(path).matrix; }
+    /// Transform of an object relative to this entity
+    Q_INVOKABLE QMatrix4x4 objectWorldMatrix(const QString& path) const { return _transforms.value(path).worldMatrix; }
+
+    /// Hit/miss counters and memory use of the archive cache shared by all entities
+    Q_INVOKABLE QVariantMap archiveCacheStatistics() const;
+    /// Release the archives and point clouds cached by all entities
+    Q_INVOKABLE void clearArchiveCache();
+
+    double time() const { return _time; }
+    void setTime(double value);
+    int frame() const;
+    void setFrame(int value);
+    bool animated() const { return _animation != nullptr; }
+    double startTime() const;
+    double endTime() const;
+    double frameRate() const;
+    int sampleCacheSize() const { return _sampleCacheSize; }
+    void setSampleCacheSize(int value);
+
     Status status() const { return _status; }
+    int loadedPointCount() const { return _loadedPointCount; }
+    int sourcePointCount() const { return _sourcePointCount; }
+    float progress() const;
+    int ioDuration() const { return _ioDuration; }
+    int instantiationDuration() const { return _instantiationDuration; }
+    QVariantMap loadStatistics() const;
     void setStatus(Status status) {
         if(status == _status)
             return;
@@ -58,9 +224,29 @@ public:
 private:
     /// Delete all child entities/components
     void clear();
-    void createMaterials();
-    void loadAbcArchive();
-    void visitAbcObject(const Alembic::Abc::IObject&, QEntity* parent);
+    /// Use the shared locator geometry of the current locator style
+    void updateLocatorGeometry();
+    /// Enable the point cloud materials of this entity according to the point size of the materials
+    void onMaterialsPointSizeChanged();
+    /// Load the archive; an incremental load keeps the current entities and only rebuilds the changed ones
+    void loadAbcArchive(bool incremental = false);
+    /// Watch the source file if watch is enabled
+    void updateWatcher();
+    /// Reload the archive if its file has changed since the last load
+    void reloadIfChanged();
+    /// Create the entity described by node and its children
+    void instantiateNode(const SceneNode& node, QEntity* parent);
+    /// Update the entities of the previous load from node and its children, reusing those of the same path and type.
+    /// Reused entities are removed from entities.
+    void updateNode(const SceneNode& node, QEntity* parent, QHash<QString, BaseAlembicObject*>& entities);
+    /// Create the entity of node, without its children
+    BaseAlembicObject* createEntity(const SceneNode& node, QEntity* parent);
+    /// Set the data, transform and properties of node to its entity
+    void updateEntity(BaseAlembicObject* entity, const SceneNode& node);
+    /// Gather the bounds of point clouds and cameras
+    void updateBoundingBox();
+    /// Update animated entities with the values of sample
+    void applySample(const std::shared_ptr<const SceneSample>& sample);
 
     QQmlListProperty<CameraLocatorEntity> cameras() {
         return {this, _cameras};
@@ -70,34 +256,114 @@ private:
         return {this, _pointClouds};
     }
 
+    QQmlListProperty<MeshEntity> meshes() {
+        return {this, _meshes};
+    }
+
 public:
     Q_SIGNAL void sourceChanged();
     Q_SIGNAL void camerasChanged();
     Q_SIGNAL void pointSizeChanged();
+    Q_SIGNAL void pointStyleChanged();
+    Q_SIGNAL void adaptivePointSizeChanged();
+    Q_SIGNAL void pointPickingChanged();
     Q_SIGNAL void pointCloudsChanged();
+    Q_SIGNAL void meshesChanged();
     Q_SIGNAL void locatorScaleChanged();
     Q_SIGNAL void objectPicked(Qt3DCore::QTransform* transform);
     Q_SIGNAL void statusChanged(Status status);
     Q_SIGNAL void skipHiddenChanged();
+    Q_SIGNAL void batchCamerasChanged();
+    Q_SIGNAL void flattenHierarchyChanged();
+    Q_SIGNAL void streamingChanged();
+    Q_SIGNAL void chunkSizeChanged();
+    Q_SIGNAL void threadCountChanged();
+    Q_SIGNAL void memoryMappedChanged();
+    Q_SIGNAL void loadedPointCountChanged();
+    Q_SIGNAL void maxPointsChanged();
+    Q_SIGNAL void pointBudgetChanged();
+    Q_SIGNAL void cameraChanged();
+    Q_SIGNAL void vertexFormatChanged();
+    Q_SIGNAL void locatorStyleChanged();
+    Q_SIGNAL void timeChanged();
+    Q_SIGNAL void animationChanged();
+    Q_SIGNAL void prefetchFramesChanged();
+    Q_SIGNAL void sampleCacheSizeChanged();
+    Q_SIGNAL void boundingBoxChanged();
+    Q_SIGNAL void traceFileChanged();
+    Q_SIGNAL void watchChanged();
 
 protected:
     /// Scale child locators
     void scaleLocators() const;
+    /// Select the octree nodes to render, sharing the point budget between point clouds
+    void updateLevelOfDetail();
 
+    void onIOThreadSceneReady();
+    void onIOThreadChunksAvailable();
     void onIOThreadFinished();
+    void onSampleThreadSampleReady();
 
 private:
     Status _status = AlembicEntity::None;
     QUrl _source;
     bool _skipHidden = false;
-    float _pointSize = 0.5f;
+    bool _batchCameras = false;
+    bool _flattenHierarchy = false;
+    bool _streaming = false;
+    int _chunkSize = 1000000;
+    int _threadCount = 0;
+    bool _memoryMapped = false;
+    int _loadedPointCount = 0;
+    int _totalPointCount = 0;
+    int _sourcePointCount = 0;
+    int _maxPoints = 0;
+    int _pointBudget = 0;
+    VertexFormat _vertexFormat = AlembicEntity::Float;
+    Qt3DRender::QCamera* _camera = nullptr;
+    bool _adaptivePointSize = false;
+    bool _pointPicking = false;
     float _locatorScale = 1.0f;
-    Qt3DRender::QParameter* _pointSizeParameter;
-    Qt3DRender::QMaterial* _cloudMaterial;
-    Qt3DRender::QMaterial* _cameraMaterial;
+    LocatorStyle _locatorStyle = AlembicEntity::Frustum;
+    int _ioDuration = 0;
+    int _instantiationDuration = 0;
+    QUrl _traceFile;
+    bool _watch = false;
+    QFileSystemWatcher* _watcher = nullptr;
+    /// Coalesces the notifications of a file being written
+    QTimer* _watchTimer = nullptr;
+    /// Modification time and size of the file at the last load
+    QString _sourceStamp;
+    /// Whether the current load updates the entities of the previous one
+    bool _incremental = false;
+    /// Digests of the loaded point clouds, indexed by path
+    QHash<QString, QByteArray> _digests;
+    std::shared_ptr<LoadStatistics> _loadStatistics;
+    /// Owned by this entity or shared by the archives of a group
+    SceneMaterials* _materials;
+    LoadQueue* _loadQueue;
+    /// Locator geometry renderer, shared by all camera entities
+    Qt3DRender::QGeometryRenderer* _locatorRenderer = nullptr;
+    std::shared_ptr<const LocatorGeometry> _locatorGeometry;
     QList<CameraLocatorEntity*> _cameras;
+    CameraBatchEntity* _cameraBatch = nullptr;
     QList<PointCloudEntity*> _pointClouds;
+    QList<MeshEntity*> _meshes;
+    BoundingBox _boundingBox;
+    /// Point clouds waiting for streamed chunks, indexed by SceneNode::streamIndex
+    QHash<int, PointCloudEntity*> _streamedPointClouds;
+    TransformTable _transforms;
+    double _time = 0.0;
+    /// Time at which the current scene has been read
+    double _loadTime = 0.0;
+    int _prefetchFrames = 8;
+    int _sampleCacheSize = 512;
+    std::shared_ptr<SceneAnimation> _animation;
+    std::shared_ptr<const SceneSample> _currentSample;
+    /// Entities updated by the animation, indexed by path
+    QHash<QString, BaseAlembicObject*> _animatedEntities;
     std::unique_ptr<IOThread> _ioThread;
+    std::unique_ptr<SampleThread> _sampleThread;
 };
 
 } // namespace
@@ -0,0 +1,240 @@
+#include "AlembicInspector.hpp"
+#include "IOThread.hpp"
+#include <algorithm>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Property headers as "name (type)"
+QStringList propertyHeaders(const PropertyMap& properties)
+{
+    QStringList headers;
+    for(const QString& name : properties.names())
+    {
+        const QString dataType = properties.dataType(name);
+        headers.append(dataType.isEmpty() ? name : QStringLiteral("%1 (%2)").arg(name, dataType));
+    }
+    return headers;
+}
+
+} // namespace
+
+AlembicInspector::AlembicInspector(QObject* parent)
+    : QAbstractListModel(parent)
+    , _ioThread(new IOThread())
+{
+    connect(_ioThread.get(), &IOThread::objectsAvailable, this, &AlembicInspector::onIOThreadObjectsAvailable);
+    connect(_ioThread.get(), &IOThread::finished, this, &AlembicInspector::onIOThreadFinished);
+}
+
+// the IOThread destructor cancels the running walk
+AlembicInspector::~AlembicInspector() = default;
+
+void AlembicInspector::setSource(const QUrl& value)
+{
+    if(_source == value)
+        return;
+    _source = value;
+
+    beginResetModel();
+    _objects.clear();
+    _indices.clear();
+    _typeCounts.clear();
+    _pointCount = 0;
+    _fetchedCount = 0;
+    _requestedCount = std::max(_pageSize, 1);
+    endResetModel();
+    Q_EMIT objectCountChanged();
+
+    if(_source.isEmpty())
+    {
+        _ioThread->cancel();
+        setStatus(AlembicInspector::None);
+    }
+    else
+    {
+        setStatus(AlembicInspector::Loading);
+        LoadOptions options;
+        options.inspectOnly = true;
+        options.time = _time;
+        _ioThread->read(_source, options);
+    }
+    Q_EMIT sourceChanged();
+}
+
+void AlembicInspector::setStatus(Status status)
+{
+    if(status == _status)
+        return;
+    _status = status;
+    Q_EMIT statusChanged();
+}
+
+QVariantMap AlembicInspector::typeCounts() const
+{
+    QVariantMap counts;
+    for(auto it = _typeCounts.cbegin(); it != _typeCounts.cend(); ++it)
+        counts[SceneInspector::typeName(static_cast<SceneNode::Type>(it.key()))] = it.value();
+    return counts;
+}
+
+int AlembicInspector::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : _fetchedCount;
+}
+
+QVariant AlembicInspector::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() < 0 || index.row() >= _fetchedCount)
+        return QVariant();
+    const ObjectInfo& object = _objects[static_cast<std::size_t>(index.row())];
+    switch(role)
+    {
+    case Qt::DisplayRole:
+    case NameRole:
+        return object.name;
+    case PathRole:
+        return object.path;
+    case TypeRole:
+        return SceneInspector::typeName(object.type);
+    case SchemaRole:
+        return object.schema;
+    case ParentRole:
+        return object.parent;
+    case DepthRole:
+        return object.depth;
+    case ChildCountRole:
+        return object.childCount;
+    case SampleCountRole:
+        return object.sampleCount;
+    case PointCountRole:
+        return object.pointCount;
+    case FaceCountRole:
+        return object.faceCount;
+    case BoundingBoxRole:
+        return QVariant::fromValue(object.bounds);
+    case ArbPropertiesRole:
+        return propertyHeaders(object.arbProperties);
+    case UserPropertiesRole:
+        return propertyHeaders(object.userProperties);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> AlembicInspector::roleNames() const
+{
+    return {
+        {NameRole, "name"},
+        {PathRole, "path"},
+        {TypeRole, "type"},
+        {SchemaRole, "schema"},
+        {ParentRole, "parentIndex"},
+        {DepthRole, "depth"},
+        {ChildCountRole, "childCount"},
+        {SampleCountRole, "sampleCount"},
+        {PointCountRole, "pointCount"},
+        {FaceCountRole, "faceCount"},
+        {BoundingBoxRole, "boundingBox"},
+        {ArbPropertiesRole, "arbPropertyHeaders"},
+        {UserPropertiesRole, "userPropertyHeaders"}
+    };
+}
+
+bool AlembicInspector::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && _fetchedCount < static_cast<int>(_objects.size());
+}
+
+void AlembicInspector::fetchMore(const QModelIndex& parent)
+{
+    if(parent.isValid())
+        return;
+    // objects found later are added up to the requested count
+    _requestedCount = std::max(_requestedCount, _fetchedCount) + std::max(_pageSize, 1);
+    fetchAvailable();
+}
+
+// private
+void AlembicInspector::fetchAvailable()
+{
+    const int count = std::min(_requestedCount, static_cast<int>(_objects.size()));
+    if(count <= _fetchedCount)
+        return;
+    beginInsertRows(QModelIndex(), _fetchedCount, count - 1);
+    _fetchedCount = count;
+    endInsertRows();
+}
+
+QVariantMap AlembicInspector::get(int index) const
+{
+    QVariantMap map;
+    if(index < 0 || index >= static_cast<int>(_objects.size()))
+        return map;
+    // data() only serves fetched rows: read the object directly
+    const ObjectInfo& object = _objects[static_cast<std::size_t>(index)];
+    map["name"] = object.name;
+    map["path"] = object.path;
+    map["type"] = SceneInspector::typeName(object.type);
+    map["schema"] = object.schema;
+    map["parentIndex"] = object.parent;
+    map["depth"] = object.depth;
+    map["childCount"] = object.childCount;
+    map["sampleCount"] = object.sampleCount;
+    map["pointCount"] = object.pointCount;
+    map["faceCount"] = object.faceCount;
+    map["boundingBox"] = QVariant::fromValue(object.bounds);
+    map["arbPropertyHeaders"] = propertyHeaders(object.arbProperties);
+    map["userPropertyHeaders"] = propertyHeaders(object.userProperties);
+    return map;
+}
+
+QVariantMap AlembicInspector::userProperties(int index) const
+{
+    if(index < 0 || index >= static_cast<int>(_objects.size()))
+        return QVariantMap();
+    return _objects[static_cast<std::size_t>(index)].userProperties.variantMap();
+}
+
+QVariantMap AlembicInspector::arbProperties(int index) const
+{
+    if(index < 0 || index >= static_cast<int>(_objects.size()))
+        return QVariantMap();
+    return _objects[static_cast<std::size_t>(index)].arbProperties.variantMap();
+}
+
+void AlembicInspector::onIOThreadObjectsAvailable()
+{
+    std::vector<ObjectInfo> objects = _ioThread->takeObjects();
+    if(objects.empty())
+        return;
+    _objects.reserve(_objects.size() + objects.size());
+    for(auto& object : objects)
+    {
+        _indices.insert(object.path, static_cast<int>(_objects.size()));
+        _typeCounts[static_cast<int>(object.type)] += 1;
+        if(object.type == SceneNode::Type::Points)
+            _pointCount += object.pointCount;
+        _objects.push_back(std::move(object));
+    }
+    fetchAvailable();
+    Q_EMIT objectCountChanged();
+}
+
+void AlembicInspector::onIOThreadFinished()
+{
+    // a new request has been made since this walk, or it has been cancelled
+    if(_ioThread->isLoading() || _status != AlembicInspector::Loading)
+        return;
+    onIOThreadObjectsAvailable();
+    _ioDuration = static_cast<int>(_ioThread->readDuration());
+    const bool error = _ioThread->hasError();
+    _ioThread->clear();
+    // objects found before an error are kept
+    setStatus(error ? AlembicInspector::Error : AlembicInspector::Ready);
+}
+
+} // namespace
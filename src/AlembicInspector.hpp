@@ -0,0 +1,124 @@
+#pragma once
+
+#include "SceneInspector.hpp"
+#include <QAbstractListModel>
+#include <QHash>
+#include <QUrl>
+#include <QVariantMap>
+#include <memory>
+#include <vector>
+
+namespace abcentity
+{
+class IOThread;
+
+/**
+ * @brief List model of the objects of an archive, for previews that do not need to load it.
+ *
+ * The archive hierarchy is walked on an IOThread with SceneInspector, which only reads
+ * object headers, array dimensions and stored bounds. Objects are listed depth first as
+ * they are found; rows are exposed by pages of pageSize as views fetch more of them,
+ * while get() and indexOf() address all objects found so far.
+ */
+class AlembicInspector : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+    /// Time at which point counts and bounds are read, in seconds
+    Q_PROPERTY(double time MEMBER _time NOTIFY timeChanged)
+    /// Number of rows added by each fetch
+    Q_PROPERTY(int pageSize MEMBER _pageSize NOTIFY pageSizeChanged)
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    /// Number of objects found so far, including those not fetched yet
+    Q_PROPERTY(int objectCount READ objectCount NOTIFY objectCountChanged)
+    /// Number of objects of each type ("Xform", "Points", "Camera", "Mesh", "Unknown")
+    Q_PROPERTY(QVariantMap typeCounts READ typeCounts NOTIFY objectCountChanged)
+    /// Total number of points of the point clouds
+    Q_PROPERTY(qint64 pointCount READ pointCount NOTIFY objectCountChanged)
+    /// Time spent walking the archive on the IO thread, in milliseconds
+    Q_PROPERTY(int ioDuration READ ioDuration NOTIFY statusChanged)
+
+public:
+    // Identical to AlembicEntity::Status
+    enum Status {
+            None = 0,
+            Loading,
+            Ready,
+            Error
+    };
+    Q_ENUM(Status)
+
+    enum Roles {
+            NameRole = Qt::UserRole + 1,
+            PathRole,
+            TypeRole,
+            SchemaRole,
+            ParentRole,
+            DepthRole,
+            ChildCountRole,
+            SampleCountRole,
+            PointCountRole,
+            FaceCountRole,
+            BoundingBoxRole,
+            ArbPropertiesRole,
+            UserPropertiesRole
+    };
+
+    explicit AlembicInspector(QObject* parent = nullptr);
+    ~AlembicInspector() override;
+
+    const QUrl& source() const { return _source; }
+    void setSource(const QUrl& value);
+    Status status() const { return _status; }
+    int objectCount() const { return static_cast<int>(_objects.size()); }
+    QVariantMap typeCounts() const;
+    qint64 pointCount() const { return _pointCount; }
+    int ioDuration() const { return _ioDuration; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    /// Role values of a row; property roles list "name (type)" headers, without reading values
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    /// All the roles of an object, fetched or not, by role name
+    Q_INVOKABLE QVariantMap get(int index) const;
+    /// Index of the object of the given path, -1 if not found (yet)
+    Q_INVOKABLE int indexOf(const QString& path) const { return _indices.value(path, -1); }
+    /// Values of the user properties of an object, read on first call (large arrays are skipped)
+    Q_INVOKABLE QVariantMap userProperties(int index) const;
+    /// Values of the arbitrary geometry parameters of an object, read on first call (large arrays are skipped)
+    Q_INVOKABLE QVariantMap arbProperties(int index) const;
+
+public:
+    Q_SIGNAL void sourceChanged();
+    Q_SIGNAL void timeChanged();
+    Q_SIGNAL void pageSizeChanged();
+    Q_SIGNAL void statusChanged();
+    Q_SIGNAL void objectCountChanged();
+
+private:
+    void setStatus(Status status);
+    /// Add rows up to the number of requested rows
+    void fetchAvailable();
+    void onIOThreadObjectsAvailable();
+    void onIOThreadFinished();
+
+private:
+    QUrl _source;
+    double _time = 0.0;
+    int _pageSize = 256;
+    Status _status = AlembicInspector::None;
+    std::vector<ObjectInfo> _objects;
+    QHash<QString, int> _indices;
+    QHash<int, int> _typeCounts;
+    qint64 _pointCount = 0;
+    /// Number of rows exposed to views, and number of rows they asked for
+    int _fetchedCount = 0;
+    int _requestedCount = 0;
+    int _ioDuration = 0;
+    std::unique_ptr<IOThread> _ioThread;
+};
+
+} // namespace
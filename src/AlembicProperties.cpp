@@ -0,0 +1,208 @@
+#include "AlembicProperties.hpp"
+#include <QDebug>
+#include <QVariantList>
+
+namespace abcentity
+{
+
+namespace
+{
+
+template<typename PODTYPE>
+void addScalarProperty(QVariantMap& data, const Alembic::Abc::IScalarProperty& prop)
+{
+    static const Alembic::Abc::ISampleSelector iss((Alembic::Abc::index_t)0);
+
+    // TODO: handle extent and interpretation
+    PODTYPE val;
+    prop.get(&val, iss);
+    data[prop.getName().c_str()] = val;
+}
+
+template<>
+void addScalarProperty<std::string>(QVariantMap& data, const Alembic::Abc::IScalarProperty& prop)
+{
+    std::string val;
+    static const Alembic::Abc::ISampleSelector iss((Alembic::Abc::index_t)0);
+    prop.get(&val, iss);
+    data[prop.getName().c_str()] = QString::fromStdString(val);
+}
+
+template<typename PODTYPE>
+void addArrayProperty(QVariantMap& data, const Alembic::Abc::IArrayProperty& prop)
+{
+    Alembic::AbcCoreAbstract::ArraySamplePtr val;
+    prop.get(val);
+    const PODTYPE* _data = static_cast<const PODTYPE*>(val->getData());
+    QVariantList l;
+    l.reserve(static_cast<int>(val->size()));
+    for(size_t k=0; k < val->size(); k++)
+    {
+        l.append(_data[k]);
+    }
+    data[prop.getName().c_str()] = l;
+}
+
+template<>
+void addArrayProperty<std::string>(QVariantMap& data, const Alembic::Abc::IArrayProperty& prop)
+{
+    Alembic::AbcCoreAbstract::ArraySamplePtr val;
+    prop.get(val);
+    const std::string* _data = static_cast<const std::string*>(val->getData());
+    QVariantList l;
+    l.reserve(static_cast<int>(val->size()));
+    for(size_t k=0; k < val->size(); k++)
+    {
+        l.append(QString::fromStdString(_data[k]));
+    }
+    data[prop.getName().c_str()] = l;
+}
+
+template<typename PODTYPE>
+void addProperty(QVariantMap& data, const Alembic::Abc::ICompoundProperty& iParent,
+                 const Alembic::Abc::PropertyHeader& propHeader)
+{
+    if(propHeader.isArray())
+    {
+        Alembic::Abc::IArrayProperty prop(iParent, propHeader.getName());
+        if(!prop.isConstant() || prop.getNumSamples() == 0)
+            return;
+        // only read the dimensions to skip large arrays
+        Alembic::AbcCoreAbstract::Dimensions dims;
+        prop.getDimensions(dims);
+        if(dims.numPoints() * propHeader.getDataType().getExtent() > maxVariantArraySize)
+            return;
+        addArrayProperty<PODTYPE>(data, prop);
+    }
+    else if(propHeader.isScalar())
+    {
+        Alembic::Abc::IScalarProperty prop(iParent, propHeader.getName());
+        if(!prop.isConstant())
+            return;
+        addScalarProperty<PODTYPE>(data, prop);
+    }
+}
+
+} // namespace
+
+void fillPropertyMap(const Alembic::Abc::ICompoundProperty& iParent, QVariantMap& variantMap)
+{
+    if(!iParent.valid())
+        return;
+    std::size_t numProps = iParent.getNumProperties();
+    for (std::size_t i = 0; i < numProps; ++i)
+    {
+        const Alembic::Abc::PropertyHeader & propHeader = iParent.getPropertyHeader(i);
+        Alembic::AbcCoreAbstract::DataType dtype = propHeader.getDataType();
+
+        switch(dtype.getPod())
+        {
+        case Alembic::Abc::kBooleanPOD:
+            addProperty<bool>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kUint8POD:
+            addProperty<quint8>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kUint16POD:
+            addProperty<quint16>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kUint32POD:
+            addProperty<quint32>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kUint64POD:
+            addProperty<quint64>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kInt8POD:
+            addProperty<qint8>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kInt16POD:
+            addProperty<qint16>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kInt32POD:
+            addProperty<qint32>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kInt64POD:
+            addProperty<qint64>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kFloat16POD:
+            addProperty<float>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kFloat32POD:
+            addProperty<float>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kFloat64POD:
+            addProperty<double>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kStringPOD:
+            addProperty<std::string>(variantMap, iParent, propHeader); break;
+        case Alembic::Abc::kUnknownPOD:
+        default:
+            break;
+        }
+    }
+}
+
+PropertyMap::PropertyMap(const Alembic::Abc::ICompoundProperty& iParent)
+    : _parent(iParent)
+{
+}
+
+QStringList PropertyMap::names() const
+{
+    QStringList result;
+    if(!_parent.valid())
+        return result;
+    for(std::size_t i = 0; i < _parent.getNumProperties(); ++i)
+        result.append(QString::fromStdString(_parent.getPropertyHeader(i).getName()));
+    return result;
+}
+
+const QVariantMap& PropertyMap::variantMap() const
+{
+    if(!_resolved)
+    {
+        // read on the GUI thread from an archive that may have become unreadable since it was loaded
+        try
+        {
+            fillPropertyMap(_parent, _variantMap);
+        }
+        catch(const std::exception& e)
+        {
+            qWarning() << "[PropertyMap] Failed to read properties:" << e.what();
+            _variantMap.clear();
+        }
+        _resolved = true;
+    }
+    return _variantMap;
+}
+
+QByteArray PropertyMap::arrayData(const QString& name) const
+{
+    if(!_parent.valid())
+        return QByteArray();
+    const Alembic::Abc::PropertyHeader* header = _parent.getPropertyHeader(name.toStdString());
+    if(!header || !header->isArray())
+        return QByteArray();
+    const Alembic::AbcCoreAbstract::DataType dtype = header->getDataType();
+    if(dtype.getPod() == Alembic::Abc::kStringPOD || dtype.getPod() == Alembic::Abc::kWstringPOD ||
+       dtype.getPod() == Alembic::Abc::kUnknownPOD)
+        return QByteArray();
+    try
+    {
+        Alembic::Abc::IArrayProperty prop(_parent, header->getName());
+        if(prop.getNumSamples() == 0)
+            return QByteArray();
+        Alembic::AbcCoreAbstract::ArraySamplePtr sample;
+        prop.get(sample);
+        if(!sample)
+            return QByteArray();
+        return QByteArray(static_cast<const char*>(sample->getData()),
+                          static_cast<int>(sample->size() * dtype.getNumBytes()));
+    }
+    catch(const std::exception& e)
+    {
+        qWarning() << "[PropertyMap] Failed to read property" << name << ":" << e.what();
+        return QByteArray();
+    }
+}
+
+QString PropertyMap::dataType(const QString& name) const
+{
+    if(!_parent.valid())
+        return QString();
+    const Alembic::Abc::PropertyHeader* header = _parent.getPropertyHeader(name.toStdString());
+    if(!header || header->isCompound())
+        return QString();
+    const Alembic::AbcCoreAbstract::DataType dtype = header->getDataType();
+    return QStringLiteral("%1[%2]").arg(Alembic::Util::PODName(dtype.getPod())).arg(dtype.getExtent());
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVariantMap>
+#include <Alembic/Abc/All.h>
+
+namespace abcentity
+{
+
+/// Array properties with more elements are not converted to QVariant by fillPropertyMap
+const std::size_t maxVariantArraySize = 4096;
+
+/// report alembic properties to the given variantMap
+void fillPropertyMap(const Alembic::Abc::ICompoundProperty& iParent, QVariantMap& variantMap);
+
+/**
+ * @brief Properties of an Alembic object, read on first access.
+ *
+ * Only keeps a handle on the compound property (which keeps the archive open)
+ * until the QVariantMap is requested. Large arrays are not part of the map
+ * and can be read as raw data with arrayData().
+ * Copies share the handle but not the resolved map.
+ */
+class PropertyMap
+{
+public:
+    PropertyMap() = default;
+    explicit PropertyMap(const Alembic::Abc::ICompoundProperty& iParent);
+
+    /// Names of the properties, read from their headers only
+    QStringList names() const;
+    /// Constant properties converted to QVariants, computed on first call (not thread-safe, empty if reading fails)
+    const QVariantMap& variantMap() const;
+    /// Raw data of an array property of any size (empty for unknown, string or non-array properties, or on read errors)
+    QByteArray arrayData(const QString& name) const;
+    /// Data type of a property, as "<pod>[<extent>]" (e.g. "float32_t[3]"), empty if unknown
+    QString dataType(const QString& name) const;
+
+private:
+    Alembic::Abc::ICompoundProperty _parent;
+    mutable bool _resolved = false;
+    mutable QVariantMap _variantMap;
+};
+
+}
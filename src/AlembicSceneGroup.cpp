@@ -0,0 +1,186 @@
+#include "AlembicSceneGroup.hpp"
+#include "LoadQueue.hpp"
+#include "SceneMaterials.hpp"
+#include <Qt3DCore/QTransform>
+#include <QDebug>
+
+namespace abcentity
+{
+
+AlembicSceneGroup::AlembicSceneGroup(Qt3DCore::QNode* parent)
+    : Qt3DCore::QEntity(parent)
+    , _materials(new SceneMaterials(this))
+    , _loadQueue(new LoadQueue(this))
+{
+}
+
+void AlembicSceneGroup::setSources(const QList<QUrl>& value)
+{
+    if(_sources == value)
+        return;
+    // reuse the archives of the sources that are kept
+    QList<AlembicEntity*> previous = _archives;
+    _archives.clear();
+    for(const QUrl& source : value)
+    {
+        AlembicEntity* archive = nullptr;
+        for(int i = 0; i < previous.size() && !archive; ++i)
+        {
+            if(previous[i]->source() == source)
+                archive = previous.takeAt(i);
+        }
+        _archives.append(archive ? archive : createArchive(source));
+    }
+    for(auto* archive : previous)
+    {
+        // stop the load now rather than from a deferred deletion, then delete the transform entity holding the archive
+        disconnect(archive, nullptr, this, nullptr);
+        archive->cancelLoad();
+        delete archive->parentEntity();
+    }
+    _sources = value;
+    Q_EMIT sourcesChanged();
+    Q_EMIT archivesChanged();
+    updateStatus();
+    updateBoundingBox();
+}
+
+void AlembicSceneGroup::setArchiveProperties(const QVariantMap& value)
+{
+    if(_archiveProperties == value)
+        return;
+    _archiveProperties = value;
+    for(auto* archive : _archives)
+        applyArchiveProperties(archive);
+    Q_EMIT archivePropertiesChanged();
+}
+
+int AlembicSceneGroup::maxConcurrentLoads() const
+{
+    return _loadQueue->maxConcurrentLoads();
+}
+
+void AlembicSceneGroup::setMaxConcurrentLoads(int value)
+{
+    if(_loadQueue->maxConcurrentLoads() == value)
+        return;
+    _loadQueue->setMaxConcurrentLoads(value);
+    Q_EMIT maxConcurrentLoadsChanged();
+}
+
+float AlembicSceneGroup::progress() const
+{
+    if(_archives.isEmpty())
+        return 0.0f;
+    float progress = 0.0f;
+    for(const auto* archive : _archives)
+        progress += archive->progress();
+    return progress / static_cast<float>(_archives.size());
+}
+
+AlembicEntity* AlembicSceneGroup::archive(const QUrl& source) const
+{
+    for(auto* archive : _archives)
+    {
+        if(archive->source() == source)
+            return archive;
+    }
+    return nullptr;
+}
+
+Qt3DCore::QTransform* AlembicSceneGroup::archiveTransform(int index) const
+{
+    if(index < 0 || index >= _archives.size())
+        return nullptr;
+    const auto transforms = _archives[index]->parentEntity()->componentsOfType<Qt3DCore::QTransform>();
+    return transforms.isEmpty() ? nullptr : transforms.first();
+}
+
+QVariantMap AlembicSceneGroup::pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const
+{
+    QVariantMap picked;
+    for(auto* archive : _archives)
+    {
+        if(!archive->isEnabled() || !archive->parentEntity()->isEnabled())
+            continue;
+        QVariantMap result = archive->pickPoint(origin, direction, radius);
+        if(result.isEmpty() ||
+           (!picked.isEmpty() && result.value("distance").toFloat() >= picked.value("distance").toFloat()))
+            continue;
+        result.insert(QStringLiteral("archive"), QVariant::fromValue(archive));
+        picked = result;
+    }
+    return picked;
+}
+
+// private
+AlembicEntity* AlembicSceneGroup::createArchive(const QUrl& source)
+{
+    // AlembicEntity removes its own components when loading: place it under a transform entity
+    auto entity = new Qt3DCore::QEntity(this);
+    auto transform = new Qt3DCore::QTransform;
+    entity->addComponent(transform);
+    auto archive = new AlembicEntity(_materials, _loadQueue, entity);
+    connect(archive, &AlembicEntity::statusChanged, this, &AlembicSceneGroup::updateStatus);
+    connect(archive, &AlembicEntity::loadedPointCountChanged, this, &AlembicSceneGroup::progressChanged);
+    connect(archive, &AlembicEntity::boundingBoxChanged, this, &AlembicSceneGroup::updateBoundingBox);
+    connect(transform, &Qt3DCore::QTransform::matrixChanged, this, &AlembicSceneGroup::updateBoundingBox);
+    applyArchiveProperties(archive);
+    archive->setSource(source);
+    return archive;
+}
+
+// private
+void AlembicSceneGroup::applyArchiveProperties(AlembicEntity* archive) const
+{
+    for(auto it = _archiveProperties.cbegin(); it != _archiveProperties.cend(); ++it)
+    {
+        const QByteArray name = it.key().toUtf8();
+        // setProperty would create dynamic properties for unknown names
+        if(name == "source" || archive->metaObject()->indexOfProperty(name.constData()) < 0)
+        {
+            qWarning() << "[AlembicSceneGroup] Invalid archive property" << it.key();
+            continue;
+        }
+        archive->setProperty(name.constData(), it.value());
+    }
+}
+
+// private
+void AlembicSceneGroup::updateStatus()
+{
+    AlembicEntity::Status status = _archives.isEmpty() ? AlembicEntity::None : AlembicEntity::Ready;
+    for(const auto* archive : _archives)
+    {
+        if(archive->status() == AlembicEntity::Loading)
+        {
+            status = AlembicEntity::Loading;
+            break;
+        }
+        if(archive->status() == AlembicEntity::Error)
+            status = AlembicEntity::Error;
+    }
+    Q_EMIT progressChanged();
+    if(status == _status)
+        return;
+    _status = status;
+    Q_EMIT statusChanged();
+}
+
+// private
+void AlembicSceneGroup::updateBoundingBox()
+{
+    BoundingBox box;
+    for(int i = 0; i < _archives.size(); ++i)
+    {
+        const Qt3DCore::QTransform* transform = archiveTransform(i);
+        box.extend(transform ? _archives[i]->boundingBox().transformed(transform->matrix())
+                             : _archives[i]->boundingBox());
+    }
+    if(box == _boundingBox)
+        return;
+    _boundingBox = box;
+    Q_EMIT boundingBoxChanged();
+}
+
+} // namespace
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "AlembicEntity.hpp"
+#include <QEntity>
+#include <QList>
+#include <QQmlListProperty>
+#include <QUrl>
+#include <QVariantMap>
+
+namespace abcentity
+{
+class LoadQueue;
+class SceneMaterials;
+
+/**
+ * @brief Compose several archives into one scene.
+ *
+ * Each source is loaded by a child AlembicEntity, placed under its own transform.
+ * All archives render with the same materials and shader programs, and their loads
+ * are scheduled by a shared queue bounding the number of concurrent loads.
+ */
+class AlembicSceneGroup : public Qt3DCore::QEntity
+{
+    Q_OBJECT
+    /// Archives to load; archives of sources kept in the list are not reloaded
+    Q_PROPERTY(QList<QUrl> sources READ sources WRITE setSources NOTIFY sourcesChanged)
+    /// Properties set on each archive, e.g. {"flattenHierarchy": true, "pointSize": 0.01}. They are set before
+    /// new archives are loaded; load options changed afterwards apply to the next load of existing archives.
+    /// Point size and style are those of the shared materials: setting them on any archive applies to all.
+    Q_PROPERTY(QVariantMap archiveProperties READ archiveProperties WRITE setArchiveProperties NOTIFY archivePropertiesChanged)
+    /// Maximum number of archives loaded at the same time, unbounded if <= 0
+    Q_PROPERTY(int maxConcurrentLoads READ maxConcurrentLoads WRITE setMaxConcurrentLoads NOTIFY maxConcurrentLoadsChanged)
+    /// Archive entities, in the order of sources. Hide an archive by disabling it.
+    Q_PROPERTY(QQmlListProperty<abcentity::AlembicEntity> archives READ archives NOTIFY archivesChanged)
+    /// Loading while any archive is loading, Error if any archive failed, Ready otherwise (None without sources)
+    Q_PROPERTY(abcentity::AlembicEntity::Status status READ status NOTIFY statusChanged)
+    /// Mean progress of the archives
+    Q_PROPERTY(float progress READ progress NOTIFY progressChanged)
+    /// Bounds of all archives, in this entity's frame
+    Q_PROPERTY(abcentity::BoundingBox boundingBox READ boundingBox NOTIFY boundingBoxChanged)
+
+public:
+    explicit AlembicSceneGroup(Qt3DCore::QNode* = nullptr);
+    ~AlembicSceneGroup() override = default;
+
+    const QList<QUrl>& sources() const { return _sources; }
+    void setSources(const QList<QUrl>& value);
+    const QVariantMap& archiveProperties() const { return _archiveProperties; }
+    void setArchiveProperties(const QVariantMap& value);
+    int maxConcurrentLoads() const;
+    void setMaxConcurrentLoads(int value);
+
+    AlembicEntity::Status status() const { return _status; }
+    float progress() const;
+    const BoundingBox& boundingBox() const { return _boundingBox; }
+
+    /// Archive loading the given source, null if not in sources
+    Q_INVOKABLE abcentity::AlembicEntity* archive(const QUrl& source) const;
+    /// Transform placing the archive of the given index in the group
+    Q_INVOKABLE Qt3DCore::QTransform* archiveTransform(int index) const;
+    /**
+     * @brief Pick the first point along a ray in world coordinates, among the enabled archives.
+     * @return the result of AlembicEntity::pickPoint with the "archive" entity, or an empty map
+     */
+    Q_INVOKABLE QVariantMap pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const;
+
+public:
+    Q_SIGNAL void sourcesChanged();
+    Q_SIGNAL void archivePropertiesChanged();
+    Q_SIGNAL void maxConcurrentLoadsChanged();
+    Q_SIGNAL void archivesChanged();
+    Q_SIGNAL void statusChanged();
+    Q_SIGNAL void progressChanged();
+    Q_SIGNAL void boundingBoxChanged();
+
+private:
+    /// Create the archive of a source under its own transform entity
+    AlembicEntity* createArchive(const QUrl& source);
+    void applyArchiveProperties(AlembicEntity* archive) const;
+    void updateStatus();
+    void updateBoundingBox();
+
+    QQmlListProperty<AlembicEntity> archives() { return {this, _archives}; }
+
+private:
+    QList<QUrl> _sources;
+    QVariantMap _archiveProperties;
+    QList<AlembicEntity*> _archives;
+    AlembicEntity::Status _status = AlembicEntity::None;
+    BoundingBox _boundingBox;
+    SceneMaterials* _materials;
+    LoadQueue* _loadQueue;
+};
+
+} // namespace
@@ -0,0 +1,292 @@
+#include "ArchiveCache.hpp"
+#include <Alembic/AbcCoreFactory/All.h>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <istream>
+#include <iterator>
+#include <streambuf>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Read-only stream buffer over memory, seekable as required by Ogawa
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const char* data, std::size_t size)
+    {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+    {
+        if(!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+        char* origin = direction == std::ios_base::beg ? eback() : (direction == std::ios_base::cur ? gptr() : egptr());
+        if(offset < eback() - origin || offset > egptr() - origin)
+            return pos_type(off_type(-1));
+        setg(eback(), origin + offset, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+};
+
+/// Memory mapping of a file and the streams reading it, one per Ogawa stream
+struct MappedStreams
+{
+    QFile file;
+    std::vector<std::unique_ptr<MemoryStreamBuffer>> buffers;
+    std::vector<std::unique_ptr<std::istream>> streams;
+};
+
+/// Map a file and create numStreams streams over it, nullptr if the file cannot be mapped
+std::shared_ptr<MappedStreams> mapFile(const QString& path, std::size_t numStreams)
+{
+    std::shared_ptr<MappedStreams> mapping = std::make_shared<MappedStreams>();
+    mapping->file.setFileName(path);
+    if(!mapping->file.open(QIODevice::ReadOnly) || mapping->file.size() <= 0)
+        return nullptr;
+    const uchar* data = mapping->file.map(0, mapping->file.size());
+    if(!data)
+        return nullptr;
+    for(std::size_t i = 0; i < std::max(numStreams, std::size_t(1)); ++i)
+    {
+        mapping->buffers.emplace_back(new MemoryStreamBuffer(reinterpret_cast<const char*>(data),
+                                                             static_cast<std::size_t>(mapping->file.size())));
+        mapping->streams.emplace_back(new std::istream(mapping->buffers.back().get()));
+    }
+    // the mapping remains valid once the file is closed
+    mapping->file.close();
+    return mapping;
+}
+
+} // namespace
+
+ArchiveCache& ArchiveCache::instance()
+{
+    static ArchiveCache cache;
+    return cache;
+}
+
+Alembic::Abc::IArchive ArchiveCache::archive(const QString& filePath, std::size_t numStreams, bool memoryMapped,
+                                             QString& key)
+{
+    const QFileInfo fileInfo(filePath);
+    const QString path = fileInfo.canonicalFilePath();
+    if(path.isEmpty())
+    {
+        key.clear();
+        return Alembic::Abc::IArchive();
+    }
+    key = QString("%1|%2|%3").arg(path).arg(fileInfo.lastModified().toMSecsSinceEpoch()).arg(fileInfo.size());
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        releaseMappings();
+        removeFile(path, key);
+        for(auto it = _archives.begin(); it != _archives.end(); ++it)
+        {
+            // an archive opened in another read mode or with fewer streams is reopened
+            if(it->key != key || !it->matches(numStreams, memoryMapped))
+                continue;
+            _archives.splice(_archives.begin(), _archives, it);
+            ++_statistics.archiveHits;
+            return _archives.front().archive;
+        }
+        ++_statistics.archiveMisses;
+    }
+
+    // open outside of the lock, other files remaining available meanwhile
+    Alembic::AbcCoreFactory::IFactory factory;
+    factory.setOgawaNumStreams(numStreams);
+    Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+    std::shared_ptr<MappedStreams> mapping = memoryMapped ? mapFile(path, numStreams) : nullptr;
+    Alembic::Abc::IArchive archive;
+    if(mapping)
+    {
+        // Ogawa reads from the mapped memory: pages are loaded by the kernel on first access
+        std::vector<std::istream*> streams;
+        for(const auto& stream : mapping->streams)
+            streams.push_back(stream.get());
+        archive = factory.getArchive(streams, coreType);
+    }
+    else
+    {
+        archive = factory.getArchive(path.toStdString(), coreType);
+    }
+    if(!archive.valid())
+        return archive;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // the same file may have been opened by another thread in the meantime
+    for(auto it = _archives.begin(); it != _archives.end(); ++it)
+    {
+        if(it->key != key)
+            continue;
+        if(it->matches(numStreams, memoryMapped))
+            return it->archive;
+        // replace the archive opened with other settings, keeping the point clouds decoded from the file
+        removeArchive(it);
+        break;
+    }
+    ArchiveEntry entry;
+    entry.key = key;
+    entry.filePath = path;
+    entry.numStreams = numStreams;
+    entry.memoryMapped = memoryMapped;
+    entry.mapping = mapping;
+    entry.archive = archive;
+    _archives.push_front(entry);
+    evict();
+    return archive;
+}
+
+std::shared_ptr<const PointCloudData> ArchiveCache::pointCloud(const QString& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto indexIt = _pointCloudIndex.find(key);
+    if(indexIt == _pointCloudIndex.end())
+    {
+        ++_statistics.pointCloudMisses;
+        return nullptr;
+    }
+    _pointClouds.splice(_pointClouds.begin(), _pointClouds, indexIt.value());
+    ++_statistics.pointCloudHits;
+    return _pointClouds.front().data;
+}
+
+void ArchiveCache::insertPointCloud(const QString& archiveKey, const QString& key, const PointCloudData& data)
+{
+    PointCloudEntry entry;
+    entry.key = key;
+    entry.archiveKey = archiveKey;
+    entry.data = std::make_shared<PointCloudData>(data);
+    entry.byteSize = data.byteSize();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_pointCloudIndex.contains(key) || entry.byteSize > _maxPointCloudBytes)
+        return;
+    _pointClouds.push_front(entry);
+    _pointCloudIndex.insert(key, _pointClouds.begin());
+    _statistics.pointCloudBytes += entry.byteSize;
+    evict();
+}
+
+QString ArchiveCache::pointCloudKey(const QString& archiveKey, const QString& objectPath, qint64 sampleIndex,
+                                    int pointCount, bool levelOfDetail, VertexFormat format, bool pointRadii,
+                                    bool pickingTree)
+{
+    return QString("%1|%2|%3|%4|%5|%6|%7|%8")
+        .arg(archiveKey, objectPath)
+        .arg(sampleIndex)
+        .arg(pointCount)
+        .arg(levelOfDetail ? 1 : 0)
+        .arg(static_cast<int>(format))
+        .arg(pointRadii ? 1 : 0)
+        .arg(pickingTree ? 1 : 0);
+}
+
+void ArchiveCache::setMaxArchives(std::size_t count)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxArchives = count;
+    evict();
+}
+
+void ArchiveCache::setMaxPointCloudBytes(std::size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxPointCloudBytes = maxBytes;
+    evict();
+}
+
+ArchiveCache::Statistics ArchiveCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Statistics statistics = _statistics;
+    statistics.archiveCount = _archives.size();
+    return statistics;
+}
+
+void ArchiveCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    while(!_archives.empty())
+        removeArchive(_archives.begin());
+    releaseMappings();
+    _pointClouds.clear();
+    _pointCloudIndex.clear();
+    _statistics = Statistics();
+}
+
+void ArchiveCache::removeFile(const QString& filePath, const QString& currentKey)
+{
+    for(auto it = _archives.begin(); it != _archives.end();)
+    {
+        if(it->filePath != filePath || it->key == currentKey)
+        {
+            ++it;
+            continue;
+        }
+        const QString staleKey = it->key;
+        auto stale = it++;
+        removeArchive(stale);
+        for(auto pcIt = _pointClouds.begin(); pcIt != _pointClouds.end();)
+        {
+            if(pcIt->archiveKey != staleKey)
+            {
+                ++pcIt;
+                continue;
+            }
+            _statistics.pointCloudBytes -= pcIt->byteSize;
+            _pointCloudIndex.remove(pcIt->key);
+            pcIt = _pointClouds.erase(pcIt);
+        }
+    }
+}
+
+void ArchiveCache::removeArchive(std::list<ArchiveEntry>::iterator it)
+{
+    if(it->mapping)
+        _evictedMappedArchives.splice(_evictedMappedArchives.end(), _archives, it);
+    else
+        _archives.erase(it);
+}
+
+void ArchiveCache::releaseMappings()
+{
+    // the archive reader is shared by all the copies of the archive and the objects read from it
+    for(auto it = _evictedMappedArchives.begin(); it != _evictedMappedArchives.end();)
+    {
+        if(it->archive.getPtr().use_count() <= 1)
+            it = _evictedMappedArchives.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ArchiveCache::evict()
+{
+    // archives still in use (e.g. by an animation) stay open until released
+    while(_archives.size() > _maxArchives)
+        removeArchive(std::prev(_archives.end()));
+    while(_statistics.pointCloudBytes > _maxPointCloudBytes && !_pointClouds.empty())
+    {
+        _statistics.pointCloudBytes -= _pointClouds.back().byteSize;
+        _pointCloudIndex.remove(_pointClouds.back().key);
+        _pointClouds.pop_back();
+    }
+}
+
+} // namespace
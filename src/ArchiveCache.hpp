@@ -0,0 +1,120 @@
+#pragma once
+
+#include "SceneDescription.hpp"
+#include <Alembic/Abc/All.h>
+#include <QHash>
+#include <QString>
+#include <list>
+#include <mutex>
+
+namespace abcentity
+{
+
+/**
+ * @brief Process-wide cache of opened archives and decoded point clouds.
+ *
+ * Shared by all AlembicEntity instances, so that reloading a file or showing it
+ * in several views does not parse and decode it again. Entries are keyed by
+ * file path, modification time and size: a modified file gets a new key, and
+ * the entries of its previous version are dropped on its next opening. A cached
+ * archive opened in another read mode or with fewer streams than requested is
+ * reopened, its point clouds remaining cached.
+ * All methods are thread-safe.
+ */
+class ArchiveCache
+{
+public:
+    struct Statistics
+    {
+        std::size_t archiveHits = 0;
+        std::size_t archiveMisses = 0;
+        std::size_t pointCloudHits = 0;
+        std::size_t pointCloudMisses = 0;
+        std::size_t archiveCount = 0;
+        /// Memory used by cached point clouds, in bytes
+        std::size_t pointCloudBytes = 0;
+    };
+
+    static ArchiveCache& instance();
+
+    /**
+     * @brief Get the archive of a local file, opening it if not cached.
+     * @param[in] filePath the file to open
+     * @param[in] numStreams minimum number of Ogawa streams of the archive
+     * @param[in] memoryMapped read the Ogawa archive from a memory mapping of the file instead of
+     *            file streams (falls back to file streams if the file cannot be mapped)
+     * @param[out] key key of the archive, to be given to pointCloud and insertPointCloud
+     * @return the archive, invalid if the file cannot be read
+     */
+    Alembic::Abc::IArchive archive(const QString& filePath, std::size_t numStreams, bool memoryMapped, QString& key);
+
+    /// Cached point cloud, or nullptr. key is built by pointCloudKey.
+    std::shared_ptr<const PointCloudData> pointCloud(const QString& key);
+    /// Cache a point cloud decoded from the archive with the given key, evicting the least recently used ones if needed.
+    void insertPointCloud(const QString& archiveKey, const QString& key, const PointCloudData& data);
+    /// Key of a point cloud sample of an archive, decoded with the given options (pointCount being the number of points kept).
+    static QString pointCloudKey(const QString& archiveKey, const QString& objectPath, qint64 sampleIndex,
+                                 int pointCount, bool levelOfDetail, VertexFormat format, bool pointRadii,
+                                 bool pickingTree);
+
+    /// Maximum number of archives kept open
+    void setMaxArchives(std::size_t count);
+    /// Maximum memory used by cached point clouds, in bytes
+    void setMaxPointCloudBytes(std::size_t maxBytes);
+
+    Statistics statistics() const;
+    /// Release all entries and reset counters.
+    void clear();
+
+private:
+    ArchiveCache() = default;
+
+    struct ArchiveEntry
+    {
+        QString key;
+        QString filePath;
+        /// Settings the archive was opened with
+        std::size_t numStreams = 0;
+        bool memoryMapped = false;
+        /// Memory mapping and streams read by the archive, if memory mapped (outlives the archive)
+        std::shared_ptr<void> mapping;
+        Alembic::Abc::IArchive archive;
+
+        /// Whether the archive can serve a request with the given settings
+        bool matches(std::size_t streams, bool mapped) const
+        {
+            return mapped == memoryMapped && streams <= numStreams;
+        }
+    };
+
+    struct PointCloudEntry
+    {
+        QString key;
+        QString archiveKey;
+        std::shared_ptr<const PointCloudData> data;
+        std::size_t byteSize = 0;
+    };
+
+    /// Drop the archive and point clouds of a previous version of a file (requires _mutex)
+    void removeFile(const QString& filePath, const QString& currentKey);
+    /// Evict least recently used entries above the limits (requires _mutex)
+    void evict();
+    /// Remove an archive from the cache, keeping its mapping while the archive is used (requires _mutex)
+    void removeArchive(std::list<ArchiveEntry>::iterator it);
+    /// Release the mappings of evicted archives no longer used (requires _mutex)
+    void releaseMappings();
+
+private:
+    mutable std::mutex _mutex;
+    /// Most recently used first
+    std::list<ArchiveEntry> _archives;
+    /// Evicted memory-mapped archives, kept until the last copy of the archive is released
+    std::list<ArchiveEntry> _evictedMappedArchives;
+    std::list<PointCloudEntry> _pointClouds;
+    QHash<QString, std::list<PointCloudEntry>::iterator> _pointCloudIndex;
+    std::size_t _maxArchives = 8;
+    std::size_t _maxPointCloudBytes = 1024 * 1024 * 1024;
+    Statistics _statistics;
+};
+
+} // namespace
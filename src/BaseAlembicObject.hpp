@@ -2,7 +2,9 @@
 
 #include <QEntity>
 #include <Qt3DCore/QTransform>
-#include <Alembic/AbcGeom/All.h>
+#include <QMatrix4x4>
+#include <QVariantMap>
+#include "AlembicProperties.hpp"
 
 namespace abcentity
 {
@@ -14,6 +16,8 @@ class BaseAlembicObject : public Qt3DCore::QEntity
 {
     Q_OBJECT
 
+    /// Full path of the object in the archive
+    Q_PROPERTY(QString path READ path CONSTANT)
     Q_PROPERTY(QVariantMap arbProperties READ arbProperties CONSTANT)
     Q_PROPERTY(QVariantMap userProperties READ userProperties CONSTANT)
 
@@ -22,31 +26,31 @@ public:
     explicit BaseAlembicObject(Qt3DCore::QNode* = nullptr);
     ~BaseAlembicObject() override = default;
 
-    void setTransform(const Alembic::Abc::M44d&);
+    void setTransform(const QMatrix4x4&);
+    /// Accumulated transform of this entity and its ancestors, up to root (excluded) if given
+    QMatrix4x4 worldMatrix(const Qt3DCore::QNode* root = nullptr) const;
 
-    const QVariantMap& arbProperties() const { return _arbProperties; }
-    const QVariantMap& userProperties() const { return _userProperties; }
+    const QString& path() const { return _path; }
+    void setPath(const QString& path) { _path = path; }
 
-    void fillArbProperties(const Alembic::Abc::ICompoundProperty& iParent);
-    void fillUserProperties(const Alembic::Abc::ICompoundProperty& iParent);
+    /// Properties are read from the archive on first access
+    const QVariantMap& arbProperties() const { return _arbProperties.variantMap(); }
+    const QVariantMap& userProperties() const { return _userProperties.variantMap(); }
 
-protected:
-    /// report alembic properties to the given variantMap
-    void fillPropertyMap(const Alembic::Abc::ICompoundProperty& iParent, QVariantMap& variantMap);
-
-    template<typename PODTYPE>
-    void addScalarProperty(QVariantMap& data, const Alembic::Abc::IScalarProperty& prop);
-
-    template<typename PODTYPE>
-    void addArrayProperty(QVariantMap &data, const Alembic::Abc::IArrayProperty& prop);
+    void setArbProperties(const PropertyMap& properties) { _arbProperties = properties; }
+    void setUserProperties(const PropertyMap& properties) { _userProperties = properties; }
 
-    template<typename PODTYPE>
-    void addProperty(QVariantMap& data, const Alembic::Abc::ICompoundProperty& iParent,
-                     const Alembic::Abc::PropertyHeader& propHeader);
+    /// Names of all arb properties, including large arrays missing from arbProperties
+    Q_INVOKABLE QStringList arbPropertyNames() const { return _arbProperties.names(); }
+    /// Raw data of an arb array property (e.g. per-point values), as an ArrayBuffer in QML
+    Q_INVOKABLE QByteArray arbPropertyData(const QString& name) const { return _arbProperties.arrayData(name); }
+    /// Data type of an arb property, to interpret arbPropertyData
+    Q_INVOKABLE QString arbPropertyType(const QString& name) const { return _arbProperties.dataType(name); }
 
 protected:
-    QVariantMap _arbProperties;
-    QVariantMap _userProperties;
+    QString _path;
+    PropertyMap _arbProperties;
+    PropertyMap _userProperties;
     Qt3DCore::QTransform* _transform;
 };
 
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QMetaType>
+#include <QVector3D>
+#include <algorithm>
+#include <limits>
+
+namespace abcentity
+{
+
+/**
+ * @brief Axis-aligned bounding box, exposed to QML as a value type.
+ */
+class BoundingBox
+{
+    Q_GADGET
+    Q_PROPERTY(QVector3D min READ min)
+    Q_PROPERTY(QVector3D max READ max)
+    Q_PROPERTY(QVector3D center READ center)
+    Q_PROPERTY(QVector3D size READ size)
+    /// Whether the box contains no point; other properties are then meaningless
+    Q_PROPERTY(bool empty READ isEmpty)
+
+public:
+    BoundingBox() = default;
+    BoundingBox(const QVector3D& min, const QVector3D& max)
+        : _min(min)
+        , _max(max)
+    {
+    }
+
+    const QVector3D& min() const { return _min; }
+    const QVector3D& max() const { return _max; }
+    QVector3D center() const { return isEmpty() ? QVector3D() : (_min + _max) * 0.5f; }
+    QVector3D size() const { return isEmpty() ? QVector3D() : _max - _min; }
+    bool isEmpty() const { return _min.x() > _max.x() || _min.y() > _max.y() || _min.z() > _max.z(); }
+
+    void extend(const QVector3D& point)
+    {
+        _min = QVector3D(std::min(_min.x(), point.x()), std::min(_min.y(), point.y()), std::min(_min.z(), point.z()));
+        _max = QVector3D(std::max(_max.x(), point.x()), std::max(_max.y(), point.y()), std::max(_max.z(), point.z()));
+    }
+
+    void extend(const BoundingBox& box)
+    {
+        if(box.isEmpty())
+            return;
+        extend(box._min);
+        extend(box._max);
+    }
+
+    /// Bounding box of this box transformed by matrix
+    BoundingBox transformed(const QMatrix4x4& matrix) const
+    {
+        BoundingBox result;
+        if(isEmpty())
+            return result;
+        for(int i = 0; i < 8; ++i)
+        {
+            const QVector3D corner(i & 1 ? _max.x() : _min.x(), i & 2 ? _max.y() : _min.y(), i & 4 ? _max.z() : _min.z());
+            result.extend(matrix.map(corner));
+        }
+        return result;
+    }
+
+    bool operator==(const BoundingBox& other) const { return _min == other._min && _max == other._max; }
+    bool operator!=(const BoundingBox& other) const { return !(*this == other); }
+
+private:
+    QVector3D _min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    QVector3D _max{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+};
+
+} // namespace
+
+Q_DECLARE_METATYPE(abcentity::BoundingBox)
@@ -0,0 +1,230 @@
+#include "CameraBatchEntity.hpp"
+#include <Qt3DRender/QMaterial>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace abcentity
+{
+
+namespace
+{
+
+Qt3DRender::QAttribute* createAttribute(Qt3DRender::QBuffer* buffer, const QString& name, uint vertexSize,
+                                        uint byteOffset, uint byteStride, uint count)
+{
+    using namespace Qt3DRender;
+    auto attribute = new QAttribute;
+    attribute->setAttributeType(QAttribute::VertexAttribute);
+    attribute->setBuffer(buffer);
+    attribute->setVertexBaseType(QAttribute::Float);
+    attribute->setVertexSize(vertexSize);
+    attribute->setByteOffset(byteOffset);
+    attribute->setByteStride(byteStride);
+    attribute->setCount(count);
+    attribute->setName(name);
+    return attribute;
+}
+
+Qt3DRender::QMaterial* createMaterial(Qt3DRender::QEffect* effect, Qt3DRender::QParameter* locatorScaleParameter)
+{
+    using namespace Qt3DRender;
+
+    // the effect is shared by all batches, only the scale is specific to this one
+    auto material = new QMaterial;
+    material->setEffect(effect);
+    material->addParameter(locatorScaleParameter);
+    return material;
+}
+
+} // namespace
+
+CameraBatchEntity::CameraBatchEntity(std::shared_ptr<const LocatorGeometry> locatorGeometry, Qt3DRender::QEffect* effect,
+                                     Qt3DCore::QNode* parent)
+    : BaseAlembicObject(parent)
+    , _locatorGeometry(std::move(locatorGeometry))
+    , _instanceBuffer(new Qt3DRender::QBuffer)
+    , _boundsBuffer(new Qt3DRender::QBuffer)
+    , _renderer(new Qt3DRender::QGeometryRenderer)
+    , _locatorScaleParameter(new Qt3DRender::QParameter(QStringLiteral("locatorScale"), 1.0f))
+{
+    using namespace Qt3DRender;
+
+    auto geometry = new QGeometry;
+
+    // shared locator geometry
+    const uint vertexCount = static_cast<uint>(_locatorGeometry->vertexCount);
+    auto vertexDataBuffer = new QBuffer;
+    vertexDataBuffer->setData(_locatorGeometry->positions);
+    geometry->addAttribute(createAttribute(vertexDataBuffer, QAttribute::defaultPositionAttributeName(), 3,
+                                           0, 3 * sizeof(float), vertexCount));
+    auto colorDataBuffer = new QBuffer;
+    colorDataBuffer->setData(_locatorGeometry->colors);
+    geometry->addAttribute(createAttribute(colorDataBuffer, QAttribute::defaultColorAttributeName(), 3,
+                                           0, 3 * sizeof(float), vertexCount));
+
+    // per-instance transforms, one mat4 split in 4 column attributes
+    for(uint column = 0; column < 4; ++column)
+    {
+        auto attribute = createAttribute(_instanceBuffer, QStringLiteral("instanceModel%1").arg(column), 4,
+                                         column * 4 * sizeof(float), 16 * sizeof(float), 0);
+        attribute->setDivisor(1);
+        geometry->addAttribute(attribute);
+        _instanceAttributes.append(attribute);
+    }
+
+    // bounding volume of all the instances, with as many vertices as the renderer draws per instance
+    auto boundsAttribute = createAttribute(_boundsBuffer, QStringLiteral("boundingVolumePosition"), 3,
+                                           0, 3 * sizeof(float), vertexCount);
+    geometry->addAttribute(boundsAttribute);
+    geometry->setBoundingVolumePositionAttribute(boundsAttribute);
+
+    _renderer->setPrimitiveType(QGeometryRenderer::Lines);
+    _renderer->setGeometry(geometry);
+    _renderer->setVertexCount(static_cast<int>(vertexCount));
+    _renderer->setFirstVertex(0);
+    _renderer->setFirstInstance(0);
+    _renderer->setInstanceCount(0);
+
+    addComponent(_renderer);
+    addComponent(createMaterial(effect, _locatorScaleParameter));
+}
+
+void CameraBatchEntity::addCameras(const SceneNode& node)
+{
+    if(node.type == SceneNode::Type::Camera)
+    {
+        _indices.insert(node.path, _names.size());
+        _names.append(node.name);
+        _matrices.append(node.worldMatrix);
+        _cameraArbProperties.append(node.arbProperties);
+        _cameraUserProperties.append(node.userProperties);
+    }
+    for(const auto& child : node.children)
+        addCameras(*child);
+}
+
+void CameraBatchEntity::update()
+{
+    QByteArray instanceData(_matrices.size() * 16 * static_cast<int>(sizeof(float)), Qt::Uninitialized);
+    float* dst = reinterpret_cast<float*>(instanceData.data());
+    for(const QMatrix4x4& matrix : _matrices)
+    {
+        // column-major, matching the instanceModel attributes
+        std::copy(matrix.constData(), matrix.constData() + 16, dst);
+        dst += 16;
+    }
+    _instanceBuffer->setData(instanceData);
+    for(auto* attribute : _instanceAttributes)
+        attribute->setCount(static_cast<uint>(_matrices.size()));
+    _renderer->setInstanceCount(_matrices.size());
+    updateBounds();
+    Q_EMIT countChanged();
+}
+
+void CameraBatchEntity::setCameraMatrix(int index, const QMatrix4x4& matrix)
+{
+    if(index >= 0 && index < _matrices.size())
+        _matrices[index] = matrix;
+}
+
+void CameraBatchEntity::setLocatorScale(float scale)
+{
+    if(_locatorScale == scale)
+        return;
+    _locatorScale = scale;
+    _locatorScaleParameter->setValue(scale);
+    updateBounds();
+}
+
+void CameraBatchEntity::updateBounds()
+{
+    float corners[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    if(!_matrices.isEmpty())
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            corners[k] = std::numeric_limits<float>::max();
+            corners[3 + k] = std::numeric_limits<float>::lowest();
+        }
+        for(const QMatrix4x4& matrix : _matrices)
+        {
+            const QVector3D center = matrix.map(QVector3D());
+            const float radius = _locatorGeometry->radius * _locatorScale * matrix.column(0).toVector3D().length();
+            for(int k = 0; k < 3; ++k)
+            {
+                corners[k] = std::min(corners[k], center[k] - radius);
+                corners[3 + k] = std::max(corners[3 + k], center[k] + radius);
+            }
+        }
+    }
+    // the bounding volume job visits the renderer's vertex count: the max corner fills the remaining vertices
+    const int vertexCount = std::max(_locatorGeometry->vertexCount, 2);
+    QByteArray bounds(vertexCount * 3 * static_cast<int>(sizeof(float)), Qt::Uninitialized);
+    float* vertices = reinterpret_cast<float*>(bounds.data());
+    std::copy(corners, corners + 3, vertices);
+    for(int i = 1; i < vertexCount; ++i)
+        std::copy(corners + 3, corners + 6, vertices + 3 * i);
+    _boundsBuffer->setData(bounds);
+}
+
+QString CameraBatchEntity::cameraName(int index) const
+{
+    return _names.value(index);
+}
+
+QMatrix4x4 CameraBatchEntity::cameraMatrix(int index) const
+{
+    return _matrices.value(index);
+}
+
+QVariantMap CameraBatchEntity::cameraArbProperties(int index) const
+{
+    if(index < 0 || index >= _cameraArbProperties.size())
+        return QVariantMap();
+    return _cameraArbProperties[index].variantMap();
+}
+
+QVariantMap CameraBatchEntity::cameraUserProperties(int index) const
+{
+    if(index < 0 || index >= _cameraUserProperties.size())
+        return QVariantMap();
+    return _cameraUserProperties[index].variantMap();
+}
+
+int CameraBatchEntity::pickCamera(const QVector3D& origin, const QVector3D& direction) const
+{
+    // Qt3D picking ignores instancing: intersect the locator bounding spheres on the CPU
+    bool invertible = false;
+    const QMatrix4x4 toLocal = worldMatrix().inverted(&invertible);
+    if(!invertible)
+        return -1;
+    const QVector3D localOrigin = toLocal.map(origin);
+    const QVector3D localDirection = toLocal.mapVector(direction).normalized();
+
+    int picked = -1;
+    float closest = std::numeric_limits<float>::max();
+    for(int i = 0; i < _matrices.size(); ++i)
+    {
+        const QMatrix4x4& matrix = _matrices[i];
+        const QVector3D center = matrix.map(QVector3D());
+        const float radius = _locatorGeometry->radius * _locatorScale * matrix.column(0).toVector3D().length();
+        // ray-sphere intersection
+        const QVector3D toCenter = center - localOrigin;
+        const float t = QVector3D::dotProduct(toCenter, localDirection);
+        const float distanceSquared = toCenter.lengthSquared() - t * t;
+        if(distanceSquared > radius * radius)
+            continue;
+        const float halfChord = std::sqrt(radius * radius - distanceSquared);
+        if(t + halfChord < 0.0f)
+            continue;
+        const float hit = std::max(t - halfChord, 0.0f);
+        if(hit >= closest)
+            continue;
+        closest = hit;
+        picked = i;
+    }
+    return picked;
+}
+
+} // namespace
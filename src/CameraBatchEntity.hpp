@@ -0,0 +1,83 @@
+#pragma once
+
+#include "BaseAlembicObject.hpp"
+#include "LocatorGeometry.hpp"
+#include "SceneDescription.hpp"
+#include <Qt3DRender/QBuffer>
+#include <Qt3DRender/QAttribute>
+#include <Qt3DRender/QEffect>
+#include <Qt3DRender/QGeometryRenderer>
+#include <Qt3DRender/QParameter>
+#include <QHash>
+#include <QVector>
+#include <QVector3D>
+
+
+namespace abcentity
+{
+
+/**
+ * @brief CameraBatchEntity renders all the camera locators of an archive with a single instanced draw call.
+ *
+ * The locator geometry is shared by all cameras, each camera being a per-instance
+ * transform relative to the parent AlembicEntity.
+ */
+class CameraBatchEntity : public BaseAlembicObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    /// effect is the camera batch effect of SceneMaterials, shared by all batches
+    CameraBatchEntity(std::shared_ptr<const LocatorGeometry> locatorGeometry, Qt3DRender::QEffect* effect,
+                      Qt3DCore::QNode* = nullptr);
+    ~CameraBatchEntity() override = default;
+
+public:
+    /// Add the cameras found in the subtree rooted at node
+    void addCameras(const SceneNode& node);
+    /// Upload the camera transforms added so far
+    void update();
+    /// Index of the camera with the given archive path, -1 if not found
+    int cameraIndex(const QString& path) const { return _indices.value(path, -1); }
+    /// Change the transform of a camera (uploaded by update())
+    void setCameraMatrix(int index, const QMatrix4x4& matrix);
+    void setLocatorScale(float scale);
+
+    int count() const { return _names.size(); }
+    Q_INVOKABLE QString cameraName(int index) const;
+    /// Transform of the camera relative to the parent AlembicEntity
+    Q_INVOKABLE QMatrix4x4 cameraMatrix(int index) const;
+    Q_INVOKABLE QVariantMap cameraArbProperties(int index) const;
+    Q_INVOKABLE QVariantMap cameraUserProperties(int index) const;
+    /**
+     * @brief Find the camera locator closest to the origin of a ray.
+     * @param origin ray origin, in world coordinates
+     * @param direction ray direction, in world coordinates
+     * @return the camera index, or -1 if no locator is hit
+     */
+    Q_INVOKABLE int pickCamera(const QVector3D& origin, const QVector3D& direction) const;
+
+public:
+    Q_SIGNAL void countChanged();
+
+private:
+    /// Update the bounding volume from camera positions and locator scale
+    void updateBounds();
+
+private:
+    std::shared_ptr<const LocatorGeometry> _locatorGeometry;
+    float _locatorScale = 1.0f;
+    QVector<QString> _names;
+    QHash<QString, int> _indices;
+    QVector<QMatrix4x4> _matrices;
+    QVector<PropertyMap> _cameraArbProperties;
+    QVector<PropertyMap> _cameraUserProperties;
+    Qt3DRender::QBuffer* _instanceBuffer;
+    Qt3DRender::QBuffer* _boundsBuffer;
+    QVector<Qt3DRender::QAttribute*> _instanceAttributes;
+    Qt3DRender::QGeometryRenderer* _renderer;
+    Qt3DRender::QParameter* _locatorScaleParameter;
+};
+
+} // namespace
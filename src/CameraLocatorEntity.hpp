@@ -5,6 +5,11 @@
 namespace abcentity
 {
 
+/**
+ * @brief CameraLocatorEntity is the entity of an Alembic camera.
+ *
+ * Its locator geometry renderer and material are components shared by all cameras (see LocatorGeometry).
+ */
 class CameraLocatorEntity : public BaseAlembicObject
 {
     Q_OBJECT
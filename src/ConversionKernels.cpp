@@ -0,0 +1,312 @@
+#include "ConversionKernels.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if !defined(ALEMBICENTITY_NO_SIMD)
+#if defined(__AVX2__)
+#define ABCENTITY_AVX2
+#endif
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define ABCENTITY_F16C
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ABCENTITY_SSE2
+#endif
+#endif
+
+#if defined(ABCENTITY_AVX2) || defined(ABCENTITY_F16C)
+#include <immintrin.h>
+#elif defined(ABCENTITY_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace abcentity
+{
+namespace kernels
+{
+
+namespace
+{
+
+inline float halfToFloatScalar(uint16_t h)
+{
+    // see https://fgiesen.wordpress.com/2012/03/28/half-to-float-done-quic/
+    const uint32_t shiftedExp = 0x7c00u << 13;
+    uint32_t bits = (h & 0x7fffu) << 13;
+    const uint32_t exp = shiftedExp & bits;
+    bits += (127u - 15u) << 23;
+    if(exp == shiftedExp)
+    {
+        // Inf/NaN
+        bits += (128u - 16u) << 23;
+    }
+    else if(exp == 0)
+    {
+        // zero/denormal: renormalize
+        bits += 1u << 23;
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        const uint32_t magicBits = 113u << 23;
+        float magic;
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        f -= magic;
+        std::memcpy(&bits, &f, sizeof(bits));
+    }
+    bits |= static_cast<uint32_t>(h & 0x8000u) << 16;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline uint8_t floatToUnorm8Scalar(float value)
+{
+    // also maps NaN to 0
+    return static_cast<uint8_t>(value > 0.0f ? (value < 1.0f ? value * 255.0f + 0.5f : 255.0f) : 0.0f);
+}
+
+#if defined(ABCENTITY_SSE2) && !defined(ABCENTITY_F16C)
+/// SSE2 version of halfToFloatScalar on 4 values stored in the low 16 bits of each lane
+inline __m128 halfToFloatSSE2(__m128i h)
+{
+    const __m128i maskNoSign = _mm_set1_epi32(0x7fff);
+    const __m128i shiftedExp = _mm_set1_epi32(0x7c00 << 13);
+    const __m128i expAdjust = _mm_set1_epi32((127 - 15) << 23);
+    const __m128i infNanAdjust = _mm_set1_epi32((128 - 16) << 23);
+    const __m128i denormAdjust = _mm_set1_epi32(1 << 23);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+
+    __m128i bits = _mm_slli_epi32(_mm_and_si128(h, maskNoSign), 13);
+    const __m128i exp = _mm_and_si128(bits, shiftedExp);
+    bits = _mm_add_epi32(bits, expAdjust);
+
+    const __m128i isInfNan = _mm_cmpeq_epi32(exp, shiftedExp);
+    bits = _mm_add_epi32(bits, _mm_and_si128(isInfNan, infNanAdjust));
+
+    const __m128i isDenorm = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+    const __m128 denorm = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, denormAdjust)), magic);
+    bits = _mm_or_si128(_mm_and_si128(isDenorm, _mm_castps_si128(denorm)), _mm_andnot_si128(isDenorm, bits));
+
+    const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+    return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+}
+#endif
+
+} // namespace
+
+void halfToFloat(const uint16_t* src, float* dst, std::size_t count)
+{
+    std::size_t i = 0;
+#if defined(ABCENTITY_AVX2) && defined(ABCENTITY_F16C)
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif defined(ABCENTITY_F16C)
+    for(; i + 4 <= count; i += 4)
+    {
+        const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+    }
+#elif defined(ABCENTITY_SSE2)
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_ps(dst + i, halfToFloatSSE2(_mm_unpacklo_epi16(h, zero)));
+        _mm_storeu_ps(dst + i + 4, halfToFloatSSE2(_mm_unpackhi_epi16(h, zero)));
+    }
+#endif
+    for(; i < count; ++i)
+        dst[i] = halfToFloatScalar(src[i]);
+}
+
+void unorm8ToFloat(const uint8_t* src, float* dst, std::size_t count)
+{
+    const float scale = 1.0f / 255.0f;
+    std::size_t i = 0;
+#if defined(ABCENTITY_AVX2)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        const __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(values, vscale));
+    }
+#elif defined(ABCENTITY_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), vscale));
+        _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), vscale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), vscale));
+    }
+#endif
+    for(; i < count; ++i)
+        dst[i] = src[i] * scale;
+}
+
+void floatToUnorm8(const float* src, uint8_t* dst, std::size_t count)
+{
+    std::size_t i = 0;
+#if defined(ABCENTITY_AVX2)
+    const __m256 vzero = _mm256_setzero_ps();
+    const __m256 vmax = _mm256_set1_ps(255.0f);
+    const __m256 vscale = _mm256_set1_ps(255.0f);
+    const __m256 vhalf = _mm256_set1_ps(0.5f);
+    for(; i + 16 <= count; i += 16)
+    {
+        // max(x, 0) returns 0 for NaN
+        const __m256 a = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), vzero), vscale), vhalf), vmax);
+        const __m256 b = _mm256_min_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), vzero), vscale), vhalf), vmax);
+        const __m256i ia = _mm256_cvttps_epi32(a);
+        const __m256i ib = _mm256_cvttps_epi32(b);
+        // pack within 128-bit lanes, then restore the order
+        const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xd8);
+        const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+    }
+#elif defined(ABCENTITY_SSE2)
+    const __m128 vzero = _mm_setzero_ps();
+    const __m128 vmax = _mm_set1_ps(255.0f);
+    const __m128 vscale = _mm_set1_ps(255.0f);
+    const __m128 vhalf = _mm_set1_ps(0.5f);
+    for(; i + 16 <= count; i += 16)
+    {
+        __m128i words[4];
+        for(int k = 0; k < 4; ++k)
+        {
+            // max(x, 0) returns 0 for NaN
+            const __m128 v = _mm_max_ps(_mm_loadu_ps(src + i + 4 * k), vzero);
+            words[k] = _mm_cvttps_epi32(_mm_min_ps(_mm_add_ps(_mm_mul_ps(v, vscale), vhalf), vmax));
+        }
+        const __m128i lo = _mm_packs_epi32(words[0], words[1]);
+        const __m128i hi = _mm_packs_epi32(words[2], words[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for(; i < count; ++i)
+        dst[i] = floatToUnorm8Scalar(src[i]);
+}
+
+void fill(float* dst, std::size_t count, float value)
+{
+    std::size_t i = 0;
+#if defined(ABCENTITY_AVX2)
+    const __m256 v = _mm256_set1_ps(value);
+    for(; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, v);
+#elif defined(ABCENTITY_SSE2)
+    const __m128 v = _mm_set1_ps(value);
+    for(; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, v);
+#endif
+    for(; i < count; ++i)
+        dst[i] = value;
+}
+
+void bounds(const float* xyz, std::size_t count, float minCorner[3], float maxCorner[3])
+{
+    const float maxValue = std::numeric_limits<float>::max();
+    const float lowestValue = std::numeric_limits<float>::lowest();
+    for(int k = 0; k < 3; ++k)
+    {
+        minCorner[k] = maxValue;
+        maxCorner[k] = lowestValue;
+    }
+    const std::size_t nvalues = 3 * count;
+    std::size_t i = 0;
+#if defined(ABCENTITY_AVX2) || defined(ABCENTITY_SSE2)
+    // W points are loaded as 3 registers of W floats: lane l of register r holds coordinate (r * W + l) % 3
+#if defined(ABCENTITY_AVX2)
+    const int width = 8;
+    __m256 vmin[3], vmax[3];
+    for(int r = 0; r < 3; ++r)
+    {
+        vmin[r] = _mm256_set1_ps(maxValue);
+        vmax[r] = _mm256_set1_ps(lowestValue);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    for(; i + 3 * width <= nvalues; i += 3 * width)
+    {
+        for(int r = 0; r < 3; ++r)
+        {
+            const __m256 v = _mm256_loadu_ps(xyz + i + r * width);
+            // v - v is 0 for finite values only: replace others by the neutral value
+            const __m256 finite = _mm256_cmp_ps(_mm256_sub_ps(v, v), zero, _CMP_EQ_OQ);
+            vmin[r] = _mm256_min_ps(vmin[r], _mm256_blendv_ps(_mm256_set1_ps(maxValue), v, finite));
+            vmax[r] = _mm256_max_ps(vmax[r], _mm256_blendv_ps(_mm256_set1_ps(lowestValue), v, finite));
+        }
+    }
+    float lanesMin[3 * width], lanesMax[3 * width];
+    for(int r = 0; r < 3; ++r)
+    {
+        _mm256_storeu_ps(lanesMin + r * width, vmin[r]);
+        _mm256_storeu_ps(lanesMax + r * width, vmax[r]);
+    }
+#else
+    const int width = 4;
+    __m128 vmin[3], vmax[3];
+    for(int r = 0; r < 3; ++r)
+    {
+        vmin[r] = _mm_set1_ps(maxValue);
+        vmax[r] = _mm_set1_ps(lowestValue);
+    }
+    for(; i + 3 * width <= nvalues; i += 3 * width)
+    {
+        for(int r = 0; r < 3; ++r)
+        {
+            const __m128 v = _mm_loadu_ps(xyz + i + r * width);
+            // v - v is 0 for finite values only: replace others by the neutral value
+            const __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(v, v), _mm_setzero_ps());
+            vmin[r] = _mm_min_ps(vmin[r], _mm_or_ps(_mm_and_ps(finite, v), _mm_andnot_ps(finite, _mm_set1_ps(maxValue))));
+            vmax[r] = _mm_max_ps(vmax[r], _mm_or_ps(_mm_and_ps(finite, v), _mm_andnot_ps(finite, _mm_set1_ps(lowestValue))));
+        }
+    }
+    float lanesMin[3 * width], lanesMax[3 * width];
+    for(int r = 0; r < 3; ++r)
+    {
+        _mm_storeu_ps(lanesMin + r * width, vmin[r]);
+        _mm_storeu_ps(lanesMax + r * width, vmax[r]);
+    }
+#endif
+    for(int l = 0; l < 3 * width; ++l)
+    {
+        minCorner[l % 3] = std::min(minCorner[l % 3], lanesMin[l]);
+        maxCorner[l % 3] = std::max(maxCorner[l % 3], lanesMax[l]);
+    }
+#endif
+    for(; i < nvalues; ++i)
+    {
+        const float v = xyz[i];
+        if(!std::isfinite(v))
+            continue;
+        minCorner[i % 3] = std::min(minCorner[i % 3], v);
+        maxCorner[i % 3] = std::max(maxCorner[i % 3], v);
+    }
+}
+
+const char* instructionSet()
+{
+#if defined(ABCENTITY_AVX2) && defined(ABCENTITY_F16C)
+    return "AVX2+F16C";
+#elif defined(ABCENTITY_AVX2)
+    return "AVX2";
+#elif defined(ABCENTITY_SSE2) && defined(ABCENTITY_F16C)
+    return "SSE2+F16C";
+#elif defined(ABCENTITY_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace kernels
+} // namespace
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace abcentity
+{
+
+/**
+ * @brief Vectorized conversion kernels used to build vertex buffers.
+ *
+ * Each kernel has an AVX2 and an SSE2 implementation, selected at compile time,
+ * and a scalar fallback. Define ALEMBICENTITY_NO_SIMD to force the scalar path.
+ */
+namespace kernels
+{
+
+/// Convert IEEE 754 half floats to floats.
+void halfToFloat(const uint16_t* src, float* dst, std::size_t count);
+/// Convert unsigned bytes to normalized floats in [0, 1].
+void unorm8ToFloat(const uint8_t* src, float* dst, std::size_t count);
+/// Convert floats to unsigned bytes, clamping to [0, 1] (NaN maps to 0).
+void floatToUnorm8(const float* src, uint8_t* dst, std::size_t count);
+/// Fill dst with value.
+void fill(float* dst, std::size_t count, float value);
+/// Bounds of count packed XYZ points, ignoring non-finite coordinates (min > max if there are none).
+void bounds(const float* xyz, std::size_t count, float minCorner[3], float maxCorner[3]);
+
+/// Name of the instruction set the kernels have been compiled for.
+const char* instructionSet();
+
+} // namespace kernels
+
+} // namespace
@@ -1,35 +1,239 @@
 #include "IOThread.hpp"
+#include "ArchiveCache.hpp"
+#include "ParallelFor.hpp"
+#include <QElapsedTimer>
 #include <QFile>
+#include <algorithm>
+#include <iterator>
 
 namespace abcentity
 {
 
-void IOThread::read(const QUrl& source)
+IOThread::~IOThread()
 {
-    _source = source;
-    start();
+    cancel();
+    wait();
+}
+
+void IOThread::read(const QUrl& source, const LoadOptions& options)
+{
+    bool startThread = false;
+    {
+        QMutexLocker lock(&_mutex);
+        invalidate();
+        _pendingSource = source;
+        _pendingOptions = options;
+        _hasPendingRequest = true;
+        startThread = !_running;
+        _running = true;
+    }
+    if(startThread)
+    {
+        // the previous main loop may still be returning
+        wait();
+        start();
+    }
+}
+
+void IOThread::cancel()
+{
+    QMutexLocker lock(&_mutex);
+    invalidate();
+    _hasPendingRequest = false;
+}
+
+void IOThread::invalidate()
+{
+    ++_generation;
+    _cancelled = true;
+    // release results of the previous load now
+    _scene.reset();
+    _sceneTaken = false;
+    _chunks.clear();
+    _objects.clear();
+}
+
+bool IOThread::isLoading() const
+{
+    QMutexLocker lock(&_mutex);
+    return _running;
 }
 
 void IOThread::run()
 {
+    for(;;)
+    {
+        QUrl source;
+        LoadOptions options;
+        int generation = 0;
+        {
+            QMutexLocker lock(&_mutex);
+            if(!_hasPendingRequest)
+            {
+                _running = false;
+                return;
+            }
+            _hasPendingRequest = false;
+            source = _pendingSource;
+            options = _pendingOptions;
+            generation = _generation;
+            _cancelled = false;
+            _error = true;
+        }
+        options.cancelled = &_cancelled;
+        load(source, options, generation);
+    }
+}
+
+void IOThread::load(const QUrl& source, const LoadOptions& options, int generation)
+{
+    QElapsedTimer timer;
+    timer.start();
+
     // ensure file exists and is valid
-    if(!_source.isValid() || !QFile::exists(_source.toLocalFile()))
-        return;
+    if(source.isValid() && QFile::exists(source.toLocalFile()))
+    {
+        try
+        {
+            // one Ogawa stream per decoding thread, for concurrent reads
+            const int threadCount = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+            LoadOptions readOptions = options;
+            Alembic::Abc::IArchive archive;
+            {
+                LoadStatistics::Scope scope(options.statistics.get(), "open");
+                archive = ArchiveCache::instance().archive(
+                    source.toLocalFile(), static_cast<std::size_t>(std::max(threadCount, 1)), options.memoryMapped,
+                    readOptions.archiveKey);
+            }
+            if(archive.valid() && options.inspectOnly)
+            {
+                LoadStatistics::Scope scope(options.statistics.get(), "inspect");
+                inspect(archive, options, generation);
+            }
+            else if(archive.valid())
+            {
+                SceneReader reader(readOptions);
+                std::unique_ptr<SceneNode> scene = reader.read(archive.getTop());
+                if(scene)
+                {
+                    {
+                        QMutexLocker lock(&_mutex);
+                        if(generation != _generation)
+                            throw LoadCancelled();
+                        _scene = std::move(scene);
+                        _error = false;
+                    }
+                    Q_EMIT sceneReady();
+                    LoadStatistics::Scope scope(options.statistics.get(), "stream");
+                    streamPointClouds(reader, options, generation);
+                }
+            }
+        }
+        catch(const LoadCancelled&)
+        {
+            // a newer request is pending: everything read is released on unwinding
+        }
+        catch(...)
+        {
+            QMutexLocker lock(&_mutex);
+            if(generation == _generation)
+                _error = true;
+        }
+    }
+
     QMutexLocker lock(&_mutex);
-    _archive = _factory.getArchive(_source.toLocalFile().toStdString(), _coreType);
+    if(generation == _generation)
+        _readDuration = timer.elapsed();
+}
+
+void IOThread::streamPointClouds(const SceneReader& reader, const LoadOptions& options, int generation)
+{
+    const int chunkSize = std::max(options.chunkSize, 1);
+    const auto& deferredPoints = reader.deferredPoints();
+    // point clouds are decoded in parallel, their chunks being queued as soon as they are ready
+    parallelFor(static_cast<int>(deferredPoints.size()), options.threadCount, [&](int i) {
+        const PointCloudData data = reader.readPointCloud(deferredPoints[i]);
+        // octree nodes reference the whole buffer: send level-of-detail clouds at once
+        const int step = data.octree ? data.npoints : chunkSize;
+        for(int first = 0; first < data.npoints; first += step)
+        {
+            PointCloudChunk chunk;
+            chunk.streamIndex = i;
+            chunk.data = data.octree ? data : data.mid(first, std::min(chunkSize, data.npoints - first));
+            {
+                QMutexLocker lock(&_mutex);
+                if(generation != _generation)
+                    throw LoadCancelled();
+                _chunks.push_back(std::move(chunk));
+            }
+            Q_EMIT chunksAvailable();
+        }
+    });
+}
+
+void IOThread::inspect(const Alembic::Abc::IArchive& archive, const LoadOptions& options, int generation)
+{
+    SceneInspector inspector(options);
+    // objects are queued by batches, so that models can show them while the walk goes on
+    inspector.inspect(archive.getTop(), [&](std::vector<ObjectInfo>&& objects) {
+        {
+            QMutexLocker lock(&_mutex);
+            if(generation != _generation)
+                throw LoadCancelled();
+            _objects.insert(_objects.end(), std::make_move_iterator(objects.begin()),
+                            std::make_move_iterator(objects.end()));
+            _error = false;
+        }
+        Q_EMIT objectsAvailable();
+    });
 }
 
 void IOThread::clear()
 {
     QMutexLocker lock(&_mutex);
-    _archive.reset();
+    _scene.reset();
+    _chunks.clear();
+    _objects.clear();
 }
 
-const Alembic::Abc::IArchive& IOThread::archive() const
+std::unique_ptr<SceneNode> IOThread::takeScene()
+{
+    QMutexLocker lock(&_mutex);
+    if(_scene)
+        _sceneTaken = true;
+    return std::move(_scene);
+}
+
+std::vector<PointCloudChunk> IOThread::takeChunks()
+{
+    QMutexLocker lock(&_mutex);
+    std::vector<PointCloudChunk> chunks;
+    // chunks refer to point clouds of the current scene
+    if(!_sceneTaken)
+        return chunks;
+    chunks.swap(_chunks);
+    return chunks;
+}
+
+std::vector<ObjectInfo> IOThread::takeObjects()
+{
+    QMutexLocker lock(&_mutex);
+    std::vector<ObjectInfo> objects;
+    objects.swap(_objects);
+    return objects;
+}
+
+bool IOThread::hasError() const
 {
     // mutex is mutable and can be locked in const methods
     QMutexLocker lock(&_mutex);
-    return _archive;
+    return _error;
 }
 
-}
\ No newline at end of file
+qint64 IOThread::readDuration() const
+{
+    QMutexLocker lock(&_mutex);
+    return _readDuration;
+}
+
+}
@@ -1,37 +1,91 @@
 #pragma once
 
+#include "SceneInspector.hpp"
+#include "SceneReader.hpp"
 #include <QThread>
 #include <QUrl>
 #include <QMutex>
+#include <atomic>
 #include <Alembic/AbcGeom/All.h>
-#include <Alembic/AbcCoreFactory/All.h>
 
 namespace abcentity
 {
 
 /**
  * @brief Handle Alembic IO in a separate thread.
+ *
+ * Opens the archive and builds its SceneNode tree, so that only Qt3D entity
+ * instantiation remains to be done on the GUI thread.
+ *
+ * With LoadOptions::inspectOnly, only gathers object metadata with SceneInspector.
+ *
+ * A new request cancels the running load; requests made meanwhile are coalesced
+ * so that only the latest one is read. Results of cancelled loads are discarded.
  */
 class IOThread : public QThread
 {
     Q_OBJECT
 
 public:
-    /// Read the given source. Starts the thread main loop.
-    void read(const QUrl& source);
-    /// Thread main loop.
+    /// Cancel the current load and wait for the thread to finish.
+    ~IOThread() override;
+
+    /// Read the given source, cancelling the current load. Starts the thread main loop if needed.
+    void read(const QUrl& source, const LoadOptions& options);
+    /// Cancel the current load and pending requests.
+    void cancel();
+    /// Whether a request is being processed (unlike isRunning, false as soon as the last load is over).
+    bool isLoading() const;
+    /// Thread main loop, reading requests until none is pending.
     void run() override;
     /// Reset internal members.
     void clear();
-    /// Get the Alembic archive.
-    const Alembic::Abc::IArchive& archive() const;
+    /// Take ownership of the scene read by the last run (nullptr on failure).
+    std::unique_ptr<SceneNode> takeScene();
+    /// Take the streamed point cloud chunks read so far (none until the scene has been taken).
+    std::vector<PointCloudChunk> takeChunks();
+    /// Take the objects inspected so far (inspectOnly requests).
+    std::vector<ObjectInfo> takeObjects();
+    /// Whether the last run failed.
+    bool hasError() const;
+    /// Time spent in the last run, in milliseconds.
+    qint64 readDuration() const;
+
+public:
+    /// Emitted from the IO thread once the scene hierarchy is available.
+    Q_SIGNAL void sceneReady();
+    /// Emitted from the IO thread when new streamed chunks are available.
+    Q_SIGNAL void chunksAvailable();
+    /// Emitted from the IO thread when new inspected objects are available.
+    Q_SIGNAL void objectsAvailable();
+
+private:
+    /// Read a source, storing results only if generation is still the current one.
+    void load(const QUrl& source, const LoadOptions& options, int generation);
+    /// Read deferred point clouds and queue them as chunks.
+    void streamPointClouds(const SceneReader& reader, const LoadOptions& options, int generation);
+    /// Inspect the archive hierarchy and queue its objects.
+    void inspect(const Alembic::Abc::IArchive& archive, const LoadOptions& options, int generation);
+    /// Clear results and cancel the running load (requires _mutex)
+    void invalidate();
 
 private:
-    QUrl _source;
     mutable QMutex _mutex;
-    Alembic::AbcCoreFactory::IFactory _factory;
-    Alembic::AbcCoreFactory::IFactory::CoreType _coreType;
-    Alembic::Abc::IArchive _archive;
+    /// Latest request, waiting for the thread
+    QUrl _pendingSource;
+    LoadOptions _pendingOptions;
+    bool _hasPendingRequest = false;
+    /// Whether the main loop is processing requests
+    bool _running = false;
+    /// Incremented by each request: results of older generations are stale
+    int _generation = 0;
+    std::atomic<bool> _cancelled{false};
+    std::unique_ptr<SceneNode> _scene;
+    bool _sceneTaken = false;
+    std::vector<PointCloudChunk> _chunks;
+    std::vector<ObjectInfo> _objects;
+    bool _error = false;
+    qint64 _readDuration = 0;
 };
 
-}
\ No newline at end of file
+}
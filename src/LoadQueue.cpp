@@ -0,0 +1,77 @@
+#include "LoadQueue.hpp"
+
+namespace abcentity
+{
+
+LoadQueue::LoadQueue(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void LoadQueue::setMaxConcurrentLoads(int value)
+{
+    _maxConcurrentLoads = value;
+    startQueued();
+}
+
+void LoadQueue::request(QObject* requester, const std::function<void()>& start)
+{
+    if(_running.contains(requester))
+    {
+        start();
+        return;
+    }
+    for(auto& load : _queued)
+    {
+        if(load.requester == requester)
+        {
+            load.start = start;
+            return;
+        }
+    }
+    // only the address is used once destroyed
+    connect(requester, &QObject::destroyed, this, [this, requester]() { release(requester); });
+    _queued.append({requester, start});
+    startQueued();
+}
+
+void LoadQueue::release(QObject* requester)
+{
+    const bool wasRunning = _running.removeOne(requester);
+    bool wasQueued = false;
+    for(int i = 0; i < _queued.size() && !wasQueued; ++i)
+    {
+        if(_queued[i].requester == requester)
+        {
+            _queued.removeAt(i);
+            wasQueued = true;
+        }
+    }
+    if(!wasRunning && !wasQueued)
+        return;
+    disconnect(requester, &QObject::destroyed, this, nullptr);
+    startQueued();
+}
+
+bool LoadQueue::isQueued(const QObject* requester) const
+{
+    for(const auto& load : _queued)
+    {
+        if(load.requester == requester)
+            return true;
+    }
+    return false;
+}
+
+void LoadQueue::startQueued()
+{
+    while(!_queued.isEmpty() && (_maxConcurrentLoads <= 0 || _running.size() < _maxConcurrentLoads))
+    {
+        const QueuedLoad load = _queued.takeFirst();
+        _running.append(load.requester);
+        // may request or release loads
+        load.start();
+    }
+}
+
+} // namespace
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <functional>
+
+namespace abcentity
+{
+
+/**
+ * @brief Bound the number of concurrent loads of several requesters, e.g. the archives of a group.
+ *
+ * Loads are started in request order on the GUI thread, as running ones are released.
+ * Requesters are released automatically when destroyed.
+ */
+class LoadQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadQueue(QObject* parent = nullptr);
+
+    /// Maximum number of running loads, unbounded if <= 0
+    int maxConcurrentLoads() const { return _maxConcurrentLoads; }
+    void setMaxConcurrentLoads(int value);
+
+    /**
+     * @brief Start a load of requester now if a slot is free, queue it otherwise.
+     *
+     * A requester that is already loading keeps its slot and is restarted immediately;
+     * a queued one only keeps its latest start function.
+     */
+    void request(QObject* requester, const std::function<void()>& start);
+    /// Free the slot or the queue entry of requester, once its load is over or has been cancelled
+    void release(QObject* requester);
+
+    bool isQueued(const QObject* requester) const;
+    int runningCount() const { return _running.size(); }
+    int queuedCount() const { return _queued.size(); }
+
+private:
+    struct QueuedLoad
+    {
+        QObject* requester;
+        std::function<void()> start;
+    };
+
+    /// Start queued loads while slots are free
+    void startQueued();
+
+private:
+    int _maxConcurrentLoads = 2;
+    QList<QObject*> _running;
+    QList<QueuedLoad> _queued;
+};
+
+} // namespace
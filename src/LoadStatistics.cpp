@@ -0,0 +1,271 @@
+#include "LoadStatistics.hpp"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(__linux__)
+#include <QTextStream>
+#include <sys/resource.h>
+#endif
+
+namespace abcentity
+{
+
+namespace
+{
+
+const char* counterName(LoadStatistics::Counter counter)
+{
+    switch(counter)
+    {
+    case LoadStatistics::Counter::Objects:
+        return "objects";
+    case LoadStatistics::Counter::PointClouds:
+        return "pointClouds";
+    case LoadStatistics::Counter::CachedPointClouds:
+        return "cachedPointClouds";
+    case LoadStatistics::Counter::PointsRead:
+        return "pointsRead";
+    case LoadStatistics::Counter::PointsUploaded:
+        return "pointsUploaded";
+    case LoadStatistics::Counter::BytesRead:
+        return "bytesRead";
+    case LoadStatistics::Counter::Entities:
+        return "entities";
+    case LoadStatistics::Counter::Meshes:
+        return "meshes";
+    case LoadStatistics::Counter::Triangles:
+        return "triangles";
+    default:
+        return "";
+    }
+}
+
+#if defined(__linux__)
+/// Read the value of a "<key>: <value> [kB]" line of a /proc/self file, in bytes for kB values
+qint64 readProcValue(const QString& fileName, const QString& key)
+{
+    QFile file("/proc/self/" + fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+    QTextStream stream(&file);
+    for(QString line = stream.readLine(); !line.isNull(); line = stream.readLine())
+    {
+        if(!line.startsWith(key + ':'))
+            continue;
+        const QStringList fields = line.mid(key.size() + 1).simplified().split(' ');
+        if(fields.isEmpty())
+            return -1;
+        return fields.first().toLongLong() * (fields.size() > 1 && fields[1] == "kB" ? 1024 : 1);
+    }
+    return -1;
+}
+#endif
+
+/// Difference between two counter values, -1 if unknown
+qint64 counterDelta(qint64 start, qint64 end)
+{
+    return start >= 0 && end >= 0 ? end - start : -1;
+}
+
+} // namespace
+
+LoadStatistics::Scope::Scope(LoadStatistics* statistics, const char* name)
+    : _statistics(statistics)
+    , _name(name)
+    , _start(statistics ? statistics->now() : 0)
+{
+}
+
+LoadStatistics::Scope::~Scope()
+{
+    if(_statistics)
+        _statistics->addEvent(_name, _start, _statistics->now() - _start);
+}
+
+LoadStatistics::LoadStatistics()
+{
+    _timer.start();
+    _residentMemoryStart = residentMemory();
+    _ioStart = ioCounters();
+}
+
+void LoadStatistics::addEvent(const char* name, qint64 start, qint64 duration)
+{
+    const Qt::HANDLE threadId = QThread::currentThreadId();
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _threads.find(threadId);
+    if(it == _threads.end())
+        it = _threads.insert(threadId, _threads.size());
+    _events.push_back({name, start, duration, it.value()});
+}
+
+void LoadStatistics::add(Counter counter, qint64 value)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _counters[static_cast<int>(counter)] += value;
+}
+
+void LoadStatistics::finish()
+{
+    const qint64 residentMemoryEnd = residentMemory();
+    const qint64 peak = peakResidentMemory();
+    const IOCounters ioEnd = ioCounters();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ioEnd = ioEnd;
+    _duration = now();
+    _residentMemoryEnd = residentMemoryEnd;
+    _peakResidentMemory = peak;
+}
+
+QVariantMap LoadStatistics::toVariantMap() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    QHash<QString, std::pair<qint64, qint64>> ranges;
+    QHash<QString, qint64> totals;
+    for(const auto& event : _events)
+    {
+        const QString name = QString::fromLatin1(event.name);
+        const qint64 end = event.start + event.duration;
+        auto it = ranges.find(name);
+        if(it == ranges.end())
+            ranges.insert(name, std::make_pair(event.start, end));
+        else
+            *it = std::make_pair(std::min(it->first, event.start), std::max(it->second, end));
+        totals[name] += event.duration;
+    }
+    QVariantMap stages;
+    for(auto it = ranges.begin(); it != ranges.end(); ++it)
+        stages[it.key()] = static_cast<double>(it->second - it->first) / 1000.0;
+    QVariantMap stageTotals;
+    for(auto it = totals.begin(); it != totals.end(); ++it)
+        stageTotals[it.key()] = static_cast<double>(it.value()) / 1000.0;
+
+    QVariantMap map;
+    map["stages"] = stages;
+    map["stageTotals"] = stageTotals;
+    for(int i = 0; i < static_cast<int>(Counter::Count); ++i)
+        map[counterName(static_cast<Counter>(i))] = _counters[i];
+    map["duration"] = static_cast<double>(_duration >= 0 ? _duration : now()) / 1000.0;
+    map["residentMemoryStart"] = _residentMemoryStart;
+    map["residentMemoryEnd"] = _residentMemoryEnd;
+    map["peakResidentMemory"] = _peakResidentMemory;
+    map["pageFaults"] = counterDelta(_ioStart.pageFaults, _ioEnd.pageFaults);
+    map["majorPageFaults"] = counterDelta(_ioStart.majorPageFaults, _ioEnd.majorPageFaults);
+    map["ioReadBytes"] = counterDelta(_ioStart.readBytes, _ioEnd.readBytes);
+    return map;
+}
+
+bool LoadStatistics::writeChromeTrace(const QString& filePath) const
+{
+    QJsonArray traceEvents;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(const auto& event : _events)
+        {
+            QJsonObject traceEvent;
+            traceEvent["name"] = QString::fromLatin1(event.name);
+            traceEvent["cat"] = "load";
+            traceEvent["ph"] = "X";
+            traceEvent["ts"] = static_cast<double>(event.start);
+            traceEvent["dur"] = static_cast<double>(event.duration);
+            traceEvent["pid"] = 0;
+            traceEvent["tid"] = event.thread;
+            traceEvents.append(traceEvent);
+        }
+        QJsonObject counters;
+        for(int i = 0; i < static_cast<int>(Counter::Count); ++i)
+            counters[counterName(static_cast<Counter>(i))] = static_cast<double>(_counters[i]);
+        QJsonObject counterEvent;
+        counterEvent["name"] = "counters";
+        counterEvent["ph"] = "C";
+        counterEvent["ts"] = static_cast<double>(_duration >= 0 ? _duration : now());
+        counterEvent["pid"] = 0;
+        counterEvent["args"] = counters;
+        traceEvents.append(counterEvent);
+    }
+    QJsonObject trace;
+    trace["traceEvents"] = traceEvents;
+    trace["displayTimeUnit"] = "ms";
+
+    QFile file(filePath);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+qint64 LoadStatistics::residentMemory()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<qint64>(counters.WorkingSetSize);
+    return -1;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        return static_cast<qint64>(info.resident_size);
+    return -1;
+#elif defined(__linux__)
+    return readProcValue("status", "VmRSS");
+#else
+    return -1;
+#endif
+}
+
+qint64 LoadStatistics::peakResidentMemory()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    return -1;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return static_cast<qint64>(usage.ru_maxrss);
+    return -1;
+#elif defined(__linux__)
+    return readProcValue("status", "VmHWM");
+#else
+    return -1;
+#endif
+}
+
+LoadStatistics::IOCounters LoadStatistics::ioCounters()
+{
+    IOCounters counters;
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+        counters.pageFaults = static_cast<qint64>(memoryCounters.PageFaultCount);
+    IO_COUNTERS ioCounters;
+    if(GetProcessIoCounters(GetCurrentProcess(), &ioCounters))
+        counters.readBytes = static_cast<qint64>(ioCounters.ReadTransferCount);
+#elif defined(__APPLE__) || defined(__linux__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        counters.pageFaults = static_cast<qint64>(usage.ru_minflt + usage.ru_majflt);
+        counters.majorPageFaults = static_cast<qint64>(usage.ru_majflt);
+    }
+#endif
+#if defined(__linux__)
+    // actual storage reads, including those of memory-mapped pages
+    counters.readBytes = readProcValue("io", "read_bytes");
+#endif
+    return counters;
+}
+
+} // namespace
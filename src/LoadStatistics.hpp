@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+#include <mutex>
+#include <vector>
+
+namespace abcentity
+{
+
+/**
+ * @brief Timings, counters and memory use of a load.
+ *
+ * Stages are recorded as timed events from any thread, to be summarized in a
+ * QVariantMap or written as a Chrome trace (chrome://tracing, Perfetto).
+ * All methods are thread-safe.
+ */
+class LoadStatistics
+{
+public:
+    enum class Counter
+    {
+        /// Archive objects visited
+        Objects = 0,
+        /// Point clouds decoded, including animation samples read during the load
+        PointClouds,
+        /// Point clouds found in the archive cache
+        CachedPointClouds,
+        /// Points read from the archive, before decimation
+        PointsRead,
+        /// Points uploaded to Qt3D
+        PointsUploaded,
+        /// Bytes of array samples read from the archive
+        BytesRead,
+        /// Qt3D entities created
+        Entities,
+        /// Polygon meshes decoded
+        Meshes,
+        /// Triangles of the decoded meshes
+        Triangles,
+        Count
+    };
+
+    /// Record the duration of a stage, from construction to destruction (no-op if statistics is null)
+    class Scope
+    {
+    public:
+        Scope(LoadStatistics* statistics, const char* name);
+        ~Scope();
+
+    private:
+        LoadStatistics* _statistics;
+        const char* _name;
+        qint64 _start;
+    };
+
+    LoadStatistics();
+
+    /// Microseconds elapsed since the start of the load
+    qint64 now() const { return _timer.nsecsElapsed() / 1000; }
+    void addEvent(const char* name, qint64 start, qint64 duration);
+    void add(Counter counter, qint64 value);
+    /// Record the memory use of the process at the end of the load
+    void finish();
+
+    /**
+     * @brief Summary of the load:
+     * - "stages": wall time of each stage in milliseconds, from its first start to its last end
+     * - "stageTotals": time of each stage summed over threads, in milliseconds
+     * - one entry per counter (e.g. "pointsRead")
+     * - "duration": total wall time in milliseconds
+     * - "residentMemoryStart", "residentMemoryEnd", "peakResidentMemory": process memory in bytes
+     *   (peak since process start, -1 if unknown)
+     * - "pageFaults", "majorPageFaults", "ioReadBytes": IO activity of the process during the load
+     *   (including other threads, -1 if unknown)
+     */
+    QVariantMap toVariantMap() const;
+    /// Write the recorded events in the Chrome trace event format.
+    bool writeChromeTrace(const QString& filePath) const;
+
+    /// Resident memory of the process, in bytes (-1 if unknown)
+    static qint64 residentMemory();
+    /// Peak resident memory of the process since its start, in bytes (-1 if unknown)
+    static qint64 peakResidentMemory();
+
+    /// Cumulated IO activity of the process (-1 if unknown)
+    struct IOCounters
+    {
+        /// Page faults, including those served without IO
+        qint64 pageFaults = -1;
+        /// Page faults that required reading from storage
+        qint64 majorPageFaults = -1;
+        /// Bytes read from storage (or through read calls, depending on the platform)
+        qint64 readBytes = -1;
+    };
+    static IOCounters ioCounters();
+
+private:
+    struct Event
+    {
+        const char* name;
+        qint64 start;
+        qint64 duration;
+        int thread;
+    };
+
+    QElapsedTimer _timer;
+    mutable std::mutex _mutex;
+    std::vector<Event> _events;
+    /// Small thread numbers, in order of first event
+    QHash<Qt::HANDLE, int> _threads;
+    qint64 _counters[static_cast<int>(Counter::Count)] = {};
+    qint64 _duration = -1;
+    qint64 _residentMemoryStart = -1;
+    qint64 _residentMemoryEnd = -1;
+    qint64 _peakResidentMemory = -1;
+    IOCounters _ioStart;
+    IOCounters _ioEnd;
+};
+
+} // namespace
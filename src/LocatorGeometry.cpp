@@ -0,0 +1,132 @@
+#include "LocatorGeometry.hpp"
+#include <Qt3DRender/QAttribute>
+#include <Qt3DRender/QBuffer>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace abcentity
+{
+
+namespace
+{
+
+const float frustumPoints[] = {
+    // Coord system
+    0.f,  0.f,  0.f,  0.5f,  0.0f,  0.0f, // X
+    0.f,  0.f,  0.f,  0.0f,  -0.5f,  0.0f, // Y
+    0.f,  0.f,  0.f,  0.0f,  0.0f,  -0.5f, // Z
+
+    // Pyramid
+    0.f,  0.f,  0.f,  -0.3f, 0.2f,  -0.3f, // TL
+    0.f,  0.f,  0.f,  -0.3f, -0.2f, -0.3f, // BL
+    0.f,  0.f,  0.f,   0.3f, -0.2f, -0.3f, // BR
+    0.f,  0.f,  0.f,   0.3f,  0.2f, -0.3f, // TR
+
+    // Image plane
+    -0.3f, -0.2f, -0.3f,  -0.3f, 0.2f, -0.3f, // L
+    -0.3f, 0.2f, -0.3f,   0.3f, 0.2f, -0.3f, // B
+    0.3f, 0.2f, -0.3f,   0.3f,  -0.2f, -0.3f, // R
+    0.3f,  -0.2f, -0.3f,  -0.3f,  -0.2f, -0.3f, // T
+
+    // Camera Up
+    -0.3f,  0.2f, -0.3f,  0.0f,  0.25f, -0.3f, // L
+    0.3f,  0.2f, -0.3f,  0.0f,  0.25f, -0.3f, // R
+};
+
+const float frustumColors[] = {
+    // Coord system
+    1.f, 0.f, 0.f, 1.f, 0.f, 0.f, // R
+    0.f, 1.f, 0.f, 0.f, 1.f, 0.f, // G
+    0.f, 0.f, 1.f, 0.f, 0.f, 1.f, // B
+    // Pyramid
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    // Image Plane
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    // Camera Up direction
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+    1.f, 1.f, 1.f, 1.f, 1.f, 1.f,
+};
+
+/// Number of vertices of the coordinate system, drawn first in the frustum locator
+const int axisVertexCount = 6;
+
+std::shared_ptr<LocatorGeometry> createGeometry(LocatorStyle style)
+{
+    const int vertexCount = style == LocatorStyle::Axis ? axisVertexCount
+                                                        : static_cast<int>(sizeof(frustumPoints) / (3 * sizeof(float)));
+    const int byteSize = vertexCount * 3 * static_cast<int>(sizeof(float));
+    auto geometry = std::make_shared<LocatorGeometry>();
+    geometry->positions = QByteArray(reinterpret_cast<const char*>(frustumPoints), byteSize);
+    geometry->colors = QByteArray(reinterpret_cast<const char*>(frustumColors), byteSize);
+    geometry->vertexCount = vertexCount;
+    for(int i = 0; i < vertexCount; ++i)
+    {
+        const float* p = frustumPoints + 3 * i;
+        geometry->radius = std::max(geometry->radius, std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+    }
+    return geometry;
+}
+
+Qt3DRender::QAttribute* createAttribute(const QByteArray& data, const QString& name, int count)
+{
+    using namespace Qt3DRender;
+    auto buffer = new QBuffer;
+    buffer->setData(data);
+    auto attribute = new QAttribute;
+    attribute->setAttributeType(QAttribute::VertexAttribute);
+    attribute->setBuffer(buffer);
+    attribute->setVertexBaseType(QAttribute::Float);
+    attribute->setVertexSize(3);
+    attribute->setByteOffset(0);
+    attribute->setByteStride(3 * sizeof(float));
+    attribute->setCount(static_cast<uint>(count));
+    attribute->setName(name);
+    return attribute;
+}
+
+} // namespace
+
+std::shared_ptr<const LocatorGeometry> LocatorGeometry::get(LocatorStyle style)
+{
+    // weak references: the geometry is destroyed with its last user
+    static std::mutex mutex;
+    static std::weak_ptr<LocatorGeometry> cache[2];
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<LocatorGeometry>& entry = cache[style == LocatorStyle::Axis ? 1 : 0];
+    std::shared_ptr<LocatorGeometry> geometry = entry.lock();
+    if(!geometry)
+    {
+        geometry = createGeometry(style);
+        entry = geometry;
+    }
+    return geometry;
+}
+
+Qt3DRender::QGeometryRenderer* LocatorGeometry::createRenderer(Qt3DCore::QNode* parent) const
+{
+    using namespace Qt3DRender;
+
+    // buffers reference the shared data (QByteArray is implicitly shared)
+    auto customGeometry = new QGeometry;
+    customGeometry->addAttribute(createAttribute(positions, QAttribute::defaultPositionAttributeName(), vertexCount));
+    customGeometry->addAttribute(createAttribute(colors, QAttribute::defaultColorAttributeName(), vertexCount));
+
+    auto customMeshRenderer = new QGeometryRenderer(parent);
+    customMeshRenderer->setInstanceCount(1);
+    customMeshRenderer->setFirstVertex(0);
+    customMeshRenderer->setFirstInstance(0);
+    customMeshRenderer->setPrimitiveType(QGeometryRenderer::Lines);
+    customMeshRenderer->setGeometry(customGeometry);
+    customMeshRenderer->setVertexCount(vertexCount);
+    return customMeshRenderer;
+}
+
+} // namespace
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QByteArray>
+#include <Qt3DRender/QGeometryRenderer>
+#include <memory>
+
+namespace abcentity
+{
+
+/// Shape of camera locators
+enum class LocatorStyle
+{
+    /// Coordinate system, view frustum and up direction
+    Frustum = 0,
+    /// Coordinate system only
+    Axis
+};
+
+/**
+ * @brief Immutable vertex data of a camera locator, drawn as lines.
+ *
+ * Instances are shared process-wide by all locators of the same style
+ * and released with their last user (see LocatorGeometry::get).
+ */
+struct LocatorGeometry
+{
+    /// float32 XYZ positions
+    QByteArray positions;
+    /// float32 RGB colors
+    QByteArray colors;
+    int vertexCount = 0;
+    /// Radius of the sphere centered on the origin enclosing all vertices
+    float radius = 0.0f;
+
+    /// Return the shared geometry of the given style, creating it if needed.
+    static std::shared_ptr<const LocatorGeometry> get(LocatorStyle style);
+
+    /// Create a geometry renderer drawing this geometry; it can be shared by several entities.
+    Qt3DRender::QGeometryRenderer* createRenderer(Qt3DCore::QNode* parent = nullptr) const;
+};
+
+} // namespace
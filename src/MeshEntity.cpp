@@ -0,0 +1,133 @@
+#include "MeshEntity.hpp"
+#include <Qt3DRender/QGeometryRenderer>
+#include <Qt3DRender/QAttribute>
+#include <Qt3DRender/QBuffer>
+
+namespace abcentity
+{
+
+MeshEntity::MeshEntity(Qt3DCore::QNode* parent)
+    : BaseAlembicObject(parent)
+{
+}
+
+namespace
+{
+
+Qt3DRender::QAttribute* createAttribute(Qt3DRender::QGeometry* geometry, const QByteArray& data,
+                                        const std::vector<DataOwner>& owners, const QString& name, uint vertexSize,
+                                        uint count)
+{
+    using namespace Qt3DRender;
+
+    auto buffer = new QBuffer;
+    buffer->setData(data);
+    DataOwnerHolder::attach(buffer, owners);
+    auto attribute = new QAttribute;
+    attribute->setAttributeType(QAttribute::VertexAttribute);
+    attribute->setBuffer(buffer);
+    attribute->setVertexBaseType(QAttribute::Float);
+    attribute->setVertexSize(vertexSize);
+    attribute->setByteOffset(0);
+    attribute->setByteStride(vertexSize * sizeof(float));
+    attribute->setCount(count);
+    attribute->setName(name);
+    geometry->addAttribute(attribute);
+    return attribute;
+}
+
+Qt3DRender::QGeometry* createGeometry(const MeshData& data)
+{
+    using namespace Qt3DRender;
+
+    auto customGeometry = new QGeometry;
+    const uint count = static_cast<uint>(data.vertexCount);
+    auto positionAttribute = createAttribute(customGeometry, data.positions, data.owners,
+                                             QAttribute::defaultPositionAttributeName(), 3, count);
+    if(!data.normals.isEmpty())
+        createAttribute(customGeometry, data.normals, data.owners, QAttribute::defaultNormalAttributeName(), 3, count);
+    if(!data.texCoords.isEmpty())
+        createAttribute(customGeometry, data.texCoords, data.owners,
+                        QAttribute::defaultTextureCoordinateAttributeName(), 2, count);
+    if(!data.colors.isEmpty())
+        createAttribute(customGeometry, data.colors, data.owners, QAttribute::defaultColorAttributeName(), 3, count);
+
+    // the bounding volume job walks the index buffer over this attribute: it must hold all the vertices
+    customGeometry->setBoundingVolumePositionAttribute(positionAttribute);
+
+    // index buffer
+    auto indexBuffer = new QBuffer;
+    indexBuffer->setData(data.indices);
+    DataOwnerHolder::attach(indexBuffer, data.owners);
+    auto indexAttribute = new QAttribute;
+    indexAttribute->setAttributeType(QAttribute::IndexAttribute);
+    indexAttribute->setBuffer(indexBuffer);
+    indexAttribute->setVertexBaseType(data.largeIndices ? QAttribute::UnsignedInt : QAttribute::UnsignedShort);
+    indexAttribute->setVertexSize(1);
+    indexAttribute->setByteOffset(0);
+    indexAttribute->setByteStride(0);
+    indexAttribute->setCount(static_cast<uint>(data.indexCount));
+    customGeometry->addAttribute(indexAttribute);
+
+    return customGeometry;
+}
+
+} // namespace
+
+void MeshEntity::setData(const MeshData& data)
+{
+    setAttributes(data);
+
+    auto renderer = new Qt3DRender::QGeometryRenderer;
+    renderer->setPrimitiveType(Qt3DRender::QGeometryRenderer::Triangles);
+    renderer->setGeometry(createGeometry(data));
+    renderer->setVertexCount(data.indexCount);
+    addComponent(renderer);
+
+    _vertexCount = data.vertexCount;
+    _triangleCount = data.indexCount / 3;
+    _boundingBox = data.bounds;
+    Q_EMIT boundingBoxChanged();
+}
+
+void MeshEntity::clearData()
+{
+    for(auto* renderer : componentsOfType<Qt3DRender::QGeometryRenderer>())
+    {
+        removeComponent(renderer);
+        renderer->deleteLater();
+    }
+    _vertexCount = 0;
+    _triangleCount = 0;
+}
+
+void MeshEntity::setAttributes(const MeshData& data)
+{
+    using namespace Qt3DRender;
+
+    const bool hasNormals = !data.normals.isEmpty();
+    const bool hasColors = !data.colors.isEmpty();
+    if(!_attributesMaterial)
+    {
+        // the shared material renders meshes without optional attributes
+        if(!hasNormals && !hasColors)
+            return;
+        const auto materials = componentsOfType<QMaterial>();
+        if(materials.isEmpty())
+            return;
+
+        // replace the shared material by one with this mesh's attributes
+        _attributesMaterial = new QMaterial(this);
+        _attributesMaterial->setEffect(materials.first()->effect());
+        _hasNormalsParameter = new QParameter(QStringLiteral("hasNormals"), false);
+        _hasColorsParameter = new QParameter(QStringLiteral("hasColors"), false);
+        _attributesMaterial->addParameter(_hasNormalsParameter);
+        _attributesMaterial->addParameter(_hasColorsParameter);
+        removeComponent(materials.first());
+        addComponent(_attributesMaterial);
+    }
+    _hasNormalsParameter->setValue(hasNormals);
+    _hasColorsParameter->setValue(hasColors);
+}
+
+} // namespace
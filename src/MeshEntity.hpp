@@ -0,0 +1,55 @@
+#pragma once
+
+#include "BaseAlembicObject.hpp"
+#include "SceneDescription.hpp"
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
+
+
+namespace abcentity
+{
+
+/**
+ * @brief MeshEntity is the entity of an Alembic polygon mesh, rendered as a single indexed draw.
+ *
+ * Meshes are triangulated on the IO thread (see SceneReader::readMesh). Without normals,
+ * faces are shaded flat; without colors, the default color of the mesh material is used.
+ */
+class MeshEntity : public BaseAlembicObject
+{
+    Q_OBJECT
+    /// Bounds of the vertices, in object space
+    Q_PROPERTY(abcentity::BoundingBox boundingBox READ boundingBox NOTIFY boundingBoxChanged)
+    Q_PROPERTY(int vertexCount READ vertexCount NOTIFY boundingBoxChanged)
+    Q_PROPERTY(int triangleCount READ triangleCount NOTIFY boundingBoxChanged)
+
+public:
+    explicit MeshEntity(Qt3DCore::QNode* = nullptr);
+    ~MeshEntity() override = default;
+
+public:
+    /// Create the geometry renderer from mesh data read by SceneReader
+    void setData(const MeshData& data);
+    /// Remove the geometry, e.g. before setting the data of a reloaded mesh
+    void clearData();
+
+    int vertexCount() const { return _vertexCount; }
+    int triangleCount() const { return _triangleCount; }
+    const BoundingBox& boundingBox() const { return _boundingBox; }
+
+    Q_SIGNAL void boundingBoxChanged();
+
+private:
+    /// Use a dedicated material enabling the optional attributes of data
+    void setAttributes(const MeshData& data);
+
+private:
+    int _vertexCount = 0;
+    int _triangleCount = 0;
+    BoundingBox _boundingBox;
+    Qt3DRender::QMaterial* _attributesMaterial = nullptr;
+    Qt3DRender::QParameter* _hasNormalsParameter = nullptr;
+    Qt3DRender::QParameter* _hasColorsParameter = nullptr;
+};
+
+} // namespace
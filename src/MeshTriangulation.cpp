@@ -0,0 +1,212 @@
+#include "MeshTriangulation.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace abcentity
+{
+
+namespace
+{
+
+const uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+/// Whether an attribute holds one value per vertex or per corner of the mesh
+bool isValid(const PolygonMesh::Attribute& attribute, const PolygonMesh& mesh)
+{
+    if(!attribute.values || attribute.components <= 0)
+        return false;
+    const std::size_t expected = attribute.perCorner ? mesh.cornerCount : mesh.vertexCount;
+    if(!attribute.indices)
+        return attribute.count == expected;
+    if(attribute.indexCount != expected)
+        return false;
+    for(std::size_t i = 0; i < attribute.indexCount; ++i)
+    {
+        if(attribute.indices[i] >= attribute.count)
+            return false;
+    }
+    return true;
+}
+
+/// Value of an attribute at a corner of a vertex
+inline const float* attributeValue(const PolygonMesh::Attribute& attribute, std::size_t corner, std::size_t vertex)
+{
+    std::size_t index = attribute.perCorner ? corner : vertex;
+    if(attribute.indices)
+        index = attribute.indices[index];
+    return attribute.values + index * static_cast<std::size_t>(attribute.components);
+}
+
+/// Gathers the values of a source attribute for each output vertex
+struct AttributeBuffer
+{
+    /// Null if the mesh has no valid attribute
+    const PolygonMesh::Attribute* source = nullptr;
+    std::vector<float> values;
+
+    void append(std::size_t corner, std::size_t vertex)
+    {
+        if(!source)
+            return;
+        const float* value = attributeValue(*source, corner, vertex);
+        values.insert(values.end(), value, value + source->components);
+    }
+
+    /// Whether the output vertex has the value of the corner (bitwise, so that identical values are always merged)
+    bool matches(uint32_t outputVertex, std::size_t corner, std::size_t vertex) const
+    {
+        if(!source)
+            return true;
+        const std::size_t size = static_cast<std::size_t>(source->components);
+        return std::memcmp(values.data() + outputVertex * size, attributeValue(*source, corner, vertex),
+                           size * sizeof(float)) == 0;
+    }
+
+    QByteArray toByteArray() const
+    {
+        return QByteArray(reinterpret_cast<const char*>(values.data()), static_cast<int>(values.size() * sizeof(float)));
+    }
+};
+
+/// Number of corners of the faces to triangulate, 0 for faces to skip
+inline std::size_t validFaceSize(const PolygonMesh& mesh, const uint32_t* cornerVertices, std::size_t firstCorner,
+                                 int32_t faceSize)
+{
+    if(faceSize < 3 || firstCorner + static_cast<std::size_t>(faceSize) > mesh.cornerCount)
+        return 0;
+    for(std::size_t c = firstCorner; c < firstCorner + static_cast<std::size_t>(faceSize); ++c)
+    {
+        if(cornerVertices[c] == kInvalidIndex)
+            return 0;
+    }
+    return static_cast<std::size_t>(faceSize);
+}
+
+/// Write the triangle fans of all valid faces
+template<typename Index>
+void writeTriangles(const PolygonMesh& mesh, const uint32_t* cornerVertices, Index* out)
+{
+    std::size_t firstCorner = 0;
+    for(std::size_t f = 0; f < mesh.faceCount; ++f)
+    {
+        const std::size_t size = validFaceSize(mesh, cornerVertices, firstCorner, mesh.faceCounts[f]);
+        const uint32_t* face = cornerVertices + firstCorner;
+        for(std::size_t i = 1; i + 1 < size; ++i)
+        {
+            *out++ = static_cast<Index>(face[0]);
+            *out++ = static_cast<Index>(face[i + 1]);
+            *out++ = static_cast<Index>(face[i]);
+        }
+        firstCorner += static_cast<std::size_t>(std::max(mesh.faceCounts[f], 0));
+    }
+}
+
+} // namespace
+
+MeshData triangulate(const PolygonMesh& mesh)
+{
+    MeshData data;
+    if(!mesh.positions || !mesh.faceCounts || !mesh.faceIndices || mesh.vertexCount == 0 ||
+       mesh.vertexCount >= kInvalidIndex)
+        return data;
+
+    AttributeBuffer normals, texCoords, colors;
+    normals.source = isValid(mesh.normals, mesh) ? &mesh.normals : nullptr;
+    texCoords.source = isValid(mesh.texCoords, mesh) ? &mesh.texCoords : nullptr;
+    colors.source = isValid(mesh.colors, mesh) ? &mesh.colors : nullptr;
+    AttributeBuffer* attributes[3] = {&normals, &texCoords, &colors};
+    bool splitVertices = false;
+    for(const auto* attribute : attributes)
+        splitVertices = splitVertices || (attribute->source && attribute->source->perCorner);
+
+    // output vertex of each corner
+    std::vector<uint32_t> cornerVertices(mesh.cornerCount, kInvalidIndex);
+    if(!splitVertices)
+    {
+        // vertices are kept as is, attributes being gathered per vertex
+        for(std::size_t c = 0; c < mesh.cornerCount; ++c)
+        {
+            const int32_t vertex = mesh.faceIndices[c];
+            if(vertex >= 0 && static_cast<std::size_t>(vertex) < mesh.vertexCount)
+                cornerVertices[c] = static_cast<uint32_t>(vertex);
+        }
+        data.vertexCount = static_cast<int>(mesh.vertexCount);
+        data.positions = QByteArray::fromRawData(reinterpret_cast<const char*>(mesh.positions),
+                                                 static_cast<int>(mesh.vertexCount * 3 * sizeof(float)));
+        for(auto* attribute : attributes)
+        {
+            if(!attribute->source)
+                continue;
+            attribute->values.reserve(mesh.vertexCount * static_cast<std::size_t>(attribute->source->components));
+            for(std::size_t v = 0; v < mesh.vertexCount; ++v)
+                attribute->append(0, v);
+        }
+    }
+    else
+    {
+        // a vertex is created for each distinct set of attribute values around a source vertex,
+        // vertices created from the same source vertex being chained from firstVertex
+        std::vector<uint32_t> firstVertex(mesh.vertexCount, kInvalidIndex);
+        std::vector<uint32_t> nextVertex;
+        std::vector<uint32_t> sourceVertices;
+        for(std::size_t c = 0; c < mesh.cornerCount; ++c)
+        {
+            const int32_t vertex = mesh.faceIndices[c];
+            if(vertex < 0 || static_cast<std::size_t>(vertex) >= mesh.vertexCount)
+                continue;
+            uint32_t output = firstVertex[vertex];
+            for(; output != kInvalidIndex; output = nextVertex[output])
+            {
+                if(normals.matches(output, c, vertex) && texCoords.matches(output, c, vertex) &&
+                   colors.matches(output, c, vertex))
+                    break;
+            }
+            if(output == kInvalidIndex)
+            {
+                output = static_cast<uint32_t>(sourceVertices.size());
+                nextVertex.push_back(firstVertex[vertex]);
+                firstVertex[vertex] = output;
+                sourceVertices.push_back(static_cast<uint32_t>(vertex));
+                for(auto* attribute : attributes)
+                    attribute->append(c, vertex);
+            }
+            cornerVertices[c] = output;
+        }
+        data.vertexCount = static_cast<int>(sourceVertices.size());
+        data.positions = QByteArray(data.vertexCount * 3 * static_cast<int>(sizeof(float)), Qt::Uninitialized);
+        float* positions = reinterpret_cast<float*>(data.positions.data());
+        for(std::size_t i = 0; i < sourceVertices.size(); ++i)
+            std::memcpy(positions + i * 3, mesh.positions + sourceVertices[i] * 3, 3 * sizeof(float));
+    }
+    if(normals.source)
+        data.normals = normals.toByteArray();
+    if(texCoords.source)
+        data.texCoords = texCoords.toByteArray();
+    if(colors.source)
+        data.colors = colors.toByteArray();
+
+    std::size_t triangleCount = 0;
+    std::size_t firstCorner = 0;
+    for(std::size_t f = 0; f < mesh.faceCount; ++f)
+    {
+        const std::size_t size = validFaceSize(mesh, cornerVertices.data(), firstCorner, mesh.faceCounts[f]);
+        triangleCount += size > 2 ? size - 2 : 0;
+        firstCorner += static_cast<std::size_t>(std::max(mesh.faceCounts[f], 0));
+    }
+    data.indexCount = static_cast<int>(triangleCount * 3);
+    data.largeIndices = data.vertexCount > std::numeric_limits<uint16_t>::max() + 1;
+    if(data.largeIndices)
+    {
+        data.indices = QByteArray(data.indexCount * static_cast<int>(sizeof(uint32_t)), Qt::Uninitialized);
+        writeTriangles(mesh, cornerVertices.data(), reinterpret_cast<uint32_t*>(data.indices.data()));
+    }
+    else
+    {
+        data.indices = QByteArray(data.indexCount * static_cast<int>(sizeof(uint16_t)), Qt::Uninitialized);
+        writeTriangles(mesh, cornerVertices.data(), reinterpret_cast<uint16_t*>(data.indices.data()));
+    }
+    return data;
+}
+
+} // namespace
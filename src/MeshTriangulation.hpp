@@ -0,0 +1,60 @@
+#pragma once
+
+#include "SceneDescription.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace abcentity
+{
+
+/**
+ * @brief Polygon mesh as stored in Alembic, referencing memory it does not own.
+ *
+ * Faces are lists of corners, each corner referencing a vertex. Attributes hold
+ * values either per vertex or per face corner, optionally through an index.
+ */
+struct PolygonMesh
+{
+    struct Attribute
+    {
+        /// Values of components floats each, null if the mesh has no such attribute
+        const float* values = nullptr;
+        /// Number of values
+        std::size_t count = 0;
+        /// Number of floats per value
+        int components = 0;
+        /// Index of the value of each vertex or corner, null if values are given directly for each of them
+        const uint32_t* indices = nullptr;
+        std::size_t indexCount = 0;
+        /// Whether values are per face corner ("facevarying" scope), per vertex otherwise
+        bool perCorner = false;
+    };
+
+    /// Packed float32 XYZ positions
+    const float* positions = nullptr;
+    std::size_t vertexCount = 0;
+    /// Number of corners of each face
+    const int32_t* faceCounts = nullptr;
+    std::size_t faceCount = 0;
+    /// Vertex index of each corner, face after face
+    const int32_t* faceIndices = nullptr;
+    std::size_t cornerCount = 0;
+
+    Attribute normals;
+    Attribute texCoords;
+    Attribute colors;
+};
+
+/**
+ * @brief Triangulate the faces of a polygon mesh into triangle fans and build its index buffer.
+ *
+ * Vertices are only split when their corners have different normals, texture coordinates
+ * or colors. Otherwise, positions are referenced without copy: mesh.positions must then
+ * outlive the result. Alembic faces being clockwise, triangles are reversed to counter-clockwise.
+ * Indices are 16-bit when possible.
+ * Faces with less than 3 corners or invalid vertex indices are skipped, as well as attributes
+ * whose size does not match the mesh.
+ */
+MeshData triangulate(const PolygonMesh& mesh);
+
+} // namespace
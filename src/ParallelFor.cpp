@@ -0,0 +1,105 @@
+#include "ParallelFor.hpp"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Whether the current thread is running the calls of a parallelFor
+thread_local bool inParallelFor = false;
+
+struct SharedState
+{
+    int count = 0;
+    std::atomic<int> next{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+    /// Number of workers inside their loop
+    int running = 0;
+    std::exception_ptr exception;
+};
+
+class Worker : public QRunnable
+{
+public:
+    Worker(const std::shared_ptr<SharedState>& state, const std::function<void(int)>& function)
+        : _state(state)
+        , _function(function)
+    {
+    }
+
+    void run() override
+    {
+        SharedState& state = *_state;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            ++state.running;
+        }
+        const bool wasInParallelFor = inParallelFor;
+        inParallelFor = true;
+        // workers started after all indices have been taken return without calling function
+        for(int i = state.next++; i < state.count; i = state.next++)
+        {
+            try
+            {
+                _function(i);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if(!state.exception)
+                    state.exception = std::current_exception();
+                // skip remaining indices
+                state.next = state.count;
+            }
+        }
+        inParallelFor = wasInParallelFor;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if(--state.running == 0)
+            state.finished.notify_all();
+    }
+
+private:
+    std::shared_ptr<SharedState> _state;
+    const std::function<void(int)>& _function;
+};
+
+} // namespace
+
+void parallelFor(int count, int threadCount, const std::function<void(int)>& function)
+{
+    if(count <= 0)
+        return;
+    QThreadPool* pool = QThreadPool::globalInstance();
+    if(threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    // the calling thread works too; nested calls run inline so that the threads stay bounded by the pool
+    threadCount = std::max(1, std::min({threadCount, count, pool->maxThreadCount() + 1}));
+    if(inParallelFor)
+        threadCount = 1;
+
+    auto state = std::make_shared<SharedState>();
+    state->count = count;
+    for(int i = 0; i < threadCount - 1; ++i)
+        pool->start(new Worker(state, function));
+    Worker(state, function).run();
+    {
+        // wait for the calls in progress on other workers, not for workers still queued
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state] { return state->running == 0; });
+    }
+    if(state->exception)
+        std::rethrow_exception(state->exception);
+}
+
+}
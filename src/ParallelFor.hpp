@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+
+namespace abcentity
+{
+
+/**
+ * @brief Call function(i) for each i in [0, count) on the global thread pool.
+ *
+ * Indices are distributed dynamically, so that tasks of uneven cost are balanced.
+ * The calling thread takes part; calls nested in a parallelFor run on the calling thread.
+ * Blocks until all calls have returned; if calls throw, remaining indices are
+ * skipped and the first exception is rethrown.
+ * @param threadCount maximum number of threads, QThread::idealThreadCount() if <= 0, bounded by the pool
+ */
+void parallelFor(int count, int threadCount, const std::function<void(int)>& function);
+
+}
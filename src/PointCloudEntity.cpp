@@ -2,7 +2,11 @@
 #include <Qt3DRender/QGeometryRenderer>
 #include <Qt3DRender/QAttribute>
 #include <Qt3DRender/QBuffer>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
 #include <Qt3DCore/QTransform>
+#include <algorithm>
+#include <cstring>
 
 namespace abcentity
 {
@@ -12,101 +16,347 @@ PointCloudEntity::PointCloudEntity(Qt3DCore::QNode* parent)
 {
 }
 
-void PointCloudEntity::setData(const Alembic::Abc::IObject& iObj)
+namespace
+{
+
+Qt3DRender::QGeometry* createGeometry(const PointCloudData& data)
 {
     using namespace Qt3DRender;
-    using namespace Alembic::Abc;
-    using namespace Alembic::AbcGeom;
 
-    // create a new geometry renderer
-    auto customMeshRenderer = new QGeometryRenderer;
     auto customGeometry = new QGeometry;
-
-    // read position data
-    IPoints points(iObj, kWrapExisting);
-    IPointsSchema schema = points.getSchema();
-    P3fArraySamplePtr positions = schema.getValue().getPositions();
-    int npoints = static_cast<int>(positions->size());
+    const int npoints = data.npoints;
+    const bool interleaved = data.format != VertexFormat::Float;
+    const bool quantized = data.format == VertexFormat::Quantized;
 
     // vertices buffer
-    QByteArray positionData((const char*)positions->get(), npoints * 3 * static_cast<int>(sizeof(float)));
     auto vertexDataBuffer = new QBuffer;
-    vertexDataBuffer->setData(positionData);
+    vertexDataBuffer->setData(interleaved ? data.vertices : data.positions);
+    // the buffers may reference sample memory, read by the render backend as long as they exist
+    DataOwnerHolder::attach(vertexDataBuffer, data.owners);
     auto positionAttribute = new QAttribute;
     positionAttribute->setAttributeType(QAttribute::VertexAttribute);
     positionAttribute->setBuffer(vertexDataBuffer);
-    positionAttribute->setVertexBaseType(QAttribute::Float);
+    // integer attributes are normalized to [0, 1] by Qt3D
+    positionAttribute->setVertexBaseType(quantized ? QAttribute::UnsignedShort : QAttribute::Float);
     positionAttribute->setVertexSize(3);
     positionAttribute->setByteOffset(0);
-    positionAttribute->setByteStride(3 * sizeof(float));
+    positionAttribute->setByteStride(static_cast<uint>(vertexStride(data.format)));
     positionAttribute->setCount(static_cast<uint>(npoints));
     positionAttribute->setName(QAttribute::defaultPositionAttributeName());
     customGeometry->addAttribute(positionAttribute);
-    customGeometry->setBoundingVolumePositionAttribute(positionAttribute);
 
-    // read color data
-    auto colorDataBuffer = new QBuffer;
-
-    // check if we have a color property
-    ICompoundProperty cProp = schema.getArbGeomParams();
-    if(cProp)
-    {
-        std::size_t numProps = cProp.getNumProperties();
-        for(std::size_t i = 0; i < numProps; ++i)
-        {
-            const PropertyHeader& propHeader = cProp.getPropertyHeader(i);
-            if(propHeader.isArray())
-            {
-                const std::string& propName = propHeader.getName();
-                Alembic::Abc::IArrayProperty prop(cProp, propName);
-                std::string interp = prop.getMetaData().get("interpretation");
-                if(interp == "rgb")
-                {
-                    // Alembic::AbcCoreAbstract::DataType dType = prop.getDataType();
-                    Alembic::AbcCoreAbstract::ArraySamplePtr samp;
-                    prop.get(samp);
-                    QByteArray colorData((const char*)samp->getData(),
-                                         static_cast<int>(samp->size() * 3 * sizeof(float)));
-                    colorDataBuffer->setData(colorData);
-                    break; // set colors only once
-                }
-            }
-        }
-    }
+    // the bounding volume job visits the vertices drawn by the renderers over this attribute: it must hold them all
+    customGeometry->setBoundingVolumePositionAttribute(positionAttribute);
 
-    // if needed, fill the buffer with a default color
-    if(colorDataBuffer->data().isEmpty())
+    // colors buffer
+    QBuffer* colorDataBuffer = vertexDataBuffer;
+    if(!interleaved)
     {
-        auto colors = new float[positions->size() * 3];
-        for(size_t i = 0; i < positions->size() * 3; i++)
-            colors[i] = 0.8f;
-        QByteArray colorData((const char*)colors, npoints * 3 * static_cast<int>(sizeof(float)));
-        colorDataBuffer->setData(colorData);
+        colorDataBuffer = new QBuffer;
+        colorDataBuffer->setData(data.colors);
+        DataOwnerHolder::attach(colorDataBuffer, data.owners);
     }
-
-    // colors buffer
     auto colorAttribute = new QAttribute;
     colorAttribute->setAttributeType(QAttribute::VertexAttribute);
     colorAttribute->setBuffer(colorDataBuffer);
-    colorAttribute->setVertexBaseType(QAttribute::Float);
+    colorAttribute->setVertexBaseType(interleaved ? QAttribute::UnsignedByte : QAttribute::Float);
     colorAttribute->setVertexSize(3);
-    colorAttribute->setByteOffset(0);
-    colorAttribute->setByteStride(3 * sizeof(float));
+    colorAttribute->setByteOffset(interleaved ? static_cast<uint>(colorByteOffset(data.format)) : 0);
+    colorAttribute->setByteStride(static_cast<uint>(vertexStride(data.format)));
     colorAttribute->setCount(static_cast<uint>(npoints));
     colorAttribute->setName(QAttribute::defaultColorAttributeName());
     customGeometry->addAttribute(colorAttribute);
 
+    // radii buffer, the attribute reading 0 in shaders when missing
+    if(!data.radii.isEmpty())
+    {
+        auto radiusDataBuffer = new QBuffer;
+        radiusDataBuffer->setData(data.radii);
+        DataOwnerHolder::attach(radiusDataBuffer, data.owners);
+        auto radiusAttribute = new QAttribute;
+        radiusAttribute->setAttributeType(QAttribute::VertexAttribute);
+        radiusAttribute->setBuffer(radiusDataBuffer);
+        radiusAttribute->setVertexBaseType(QAttribute::Float);
+        radiusAttribute->setVertexSize(1);
+        radiusAttribute->setByteOffset(0);
+        radiusAttribute->setByteStride(sizeof(float));
+        radiusAttribute->setCount(static_cast<uint>(npoints));
+        radiusAttribute->setName("vertexRadius");
+        customGeometry->addAttribute(radiusAttribute);
+    }
+
+    return customGeometry;
+}
+
+Qt3DRender::QGeometryRenderer* createGeometryRenderer(Qt3DRender::QGeometry* geometry, int firstVertex, int vertexCount)
+{
+    using namespace Qt3DRender;
+
+    // create a new geometry renderer
+    auto customMeshRenderer = new QGeometryRenderer;
+
     // geometry renderer settings
     customMeshRenderer->setInstanceCount(1);
-    customMeshRenderer->setFirstVertex(0);
+    customMeshRenderer->setFirstVertex(firstVertex);
     customMeshRenderer->setFirstInstance(0);
     customMeshRenderer->setPrimitiveType(QGeometryRenderer::Points);
-    customMeshRenderer->setGeometry(customGeometry);
-    customMeshRenderer->setVertexCount(npoints);
+    customMeshRenderer->setGeometry(geometry);
+    customMeshRenderer->setVertexCount(vertexCount);
+
+    return customMeshRenderer;
+}
+
+} // namespace
+
+void PointCloudEntity::setData(const PointCloudData& data)
+{
+    setQuantization(data);
+    if(data.octree)
+        createLevelOfDetail(data);
+    else
+        addComponent(createGeometryRenderer(createGeometry(data), 0, data.npoints));
+    _chunks.assign(1, data);
+    _pickingTree = data.pickingTree;
+    _pointCount = data.npoints;
+    setBoundingBox(data.bounds);
+}
+
+void PointCloudEntity::addChunk(const PointCloudData& data)
+{
+    setQuantization(data);
+    BoundingBox box = _pointCount > 0 ? _boundingBox : BoundingBox();
+    box.extend(data.bounds);
+    setBoundingBox(box);
+    _chunks.push_back(data);
+    // chunks share the tree of their point cloud
+    if(data.pickingTree)
+        _pickingTree = data.pickingTree;
+    if(data.octree)
+    {
+        createLevelOfDetail(data);
+        _pointCount += data.npoints;
+        return;
+    }
+    // each chunk is rendered by a child entity sharing this entity's materials
+    auto chunkEntity = new Qt3DCore::QEntity(this);
+    chunkEntity->addComponent(createGeometryRenderer(createGeometry(data), 0, data.npoints));
+    for(auto* material : componentsOfType<Qt3DRender::QMaterial>())
+        chunkEntity->addComponent(material);
+    _pointCount += data.npoints;
+}
+
+void PointCloudEntity::clearData()
+{
+    for(auto* renderer : componentsOfType<Qt3DRender::QGeometryRenderer>())
+    {
+        removeComponent(renderer);
+        renderer->deleteLater();
+    }
+    // chunks and octree nodes (BaseAlembicObject children are Alembic objects)
+    for(auto* child : findChildren<Qt3DCore::QEntity*>(QString(), Qt::FindDirectChildrenOnly))
+    {
+        if(qobject_cast<BaseAlembicObject*>(child))
+            continue;
+        child->setParent((Qt3DCore::QNode*)nullptr);
+        child->deleteLater();
+    }
+    for(auto* geometry : findChildren<Qt3DRender::QGeometry*>(QString(), Qt::FindDirectChildrenOnly))
+        geometry->deleteLater();
+    _octreeNodeEntities.clear();
+    _octree.reset();
+    _chunks.clear();
+    _pickingTree.reset();
+    _pointCount = 0;
+    // the bounding box is kept until new data is set, so that animation samples only notify actual changes
+}
 
-    // add components
-    addComponent(customMeshRenderer);
+void PointCloudEntity::setBoundingBox(const BoundingBox& box)
+{
+    if(box == _boundingBox)
+        return;
+    _boundingBox = box;
+    Q_EMIT boundingBoxChanged();
 }
 
+void PointCloudEntity::setQuantization(const PointCloudData& data)
+{
+    using namespace Qt3DRender;
+
+    if(data.format != VertexFormat::Quantized)
+        return;
+    if(!_quantizationMaterial)
+    {
+        const auto materials = componentsOfType<QMaterial>();
+        if(materials.isEmpty())
+            return;
+
+        // replace the shared material by one with this point cloud's decoding parameters
+        _quantizationMaterial = new QMaterial(this);
+        _quantizationMaterial->setEffect(materials.first()->effect());
+        _quantizationMaterial->setEnabled(materials.first()->isEnabled());
+        _positionOffsetParameter = new QParameter(QStringLiteral("positionOffset"), QVector3D());
+        _positionScaleParameter = new QParameter(QStringLiteral("positionScale"), QVector3D(1.0f, 1.0f, 1.0f));
+        _quantizationMaterial->addParameter(_positionOffsetParameter);
+        _quantizationMaterial->addParameter(_positionScaleParameter);
+        removeComponent(materials.first());
+        addComponent(_quantizationMaterial);
+    }
+    // animation samples have their own bounding box
+    _positionOffsetParameter->setValue(
+        QVector3D(data.quantizationOffset[0], data.quantizationOffset[1], data.quantizationOffset[2]));
+    _positionScaleParameter->setValue(
+        QVector3D(data.quantizationScale[0], data.quantizationScale[1], data.quantizationScale[2]));
+}
+
+void PointCloudEntity::createLevelOfDetail(const PointCloudData& data)
+{
+    _octree = data.octree;
+
+    // all nodes share the geometry, each one rendering its own range of points
+    auto geometry = createGeometry(data);
+    geometry->setParent(this);
+    const auto materials = componentsOfType<Qt3DRender::QMaterial>();
+    for(const auto& node : _octree->nodes())
+    {
+        auto nodeEntity = new Qt3DCore::QEntity(this);
+        nodeEntity->addComponent(createGeometryRenderer(geometry, static_cast<int>(node.first),
+                                                        static_cast<int>(node.count)));
+        for(auto* material : materials)
+            nodeEntity->addComponent(material);
+        nodeEntity->setEnabled(false);
+        _octreeNodeEntities.append(nodeEntity);
+    }
+}
+
+int PointCloudEntity::updateLevelOfDetail(const Qt3DRender::QCamera* camera, int pointBudget)
+{
+    if(!_octree)
+        return _pointCount;
+
+    // without budget, all nodes are selected
+    PointOctree::SelectParams params;
+    params.pointBudget = static_cast<std::size_t>(std::max(pointBudget, 0));
+
+    // express the camera in the point cloud frame
+    float eye[3];
+    float planes[24];
+    if(camera && pointBudget > 0)
+    {
+        const QMatrix4x4 world = worldMatrix();
+        const QMatrix4x4 viewProjection = camera->projectionMatrix() * camera->viewMatrix() * world;
+        const QVector3D localEye = world.inverted().map(camera->position());
+        eye[0] = localEye.x();
+        eye[1] = localEye.y();
+        eye[2] = localEye.z();
+        PointOctree::extractFrustumPlanes(viewProjection.constData(), planes);
+        params.eye = eye;
+        params.frustumPlanes = planes;
+        params.projectionScale = camera->projectionMatrix()(1, 1);
+    }
+
+    std::size_t selectedPointCount = 0;
+    const std::vector<int> selected = _octree->select(params, &selectedPointCount);
+    QVector<bool> enabled(_octreeNodeEntities.size(), false);
+    for(int index : selected)
+        enabled[index] = true;
+    for(int i = 0; i < _octreeNodeEntities.size(); ++i)
+        _octreeNodeEntities[i]->setEnabled(enabled[i]);
+    return static_cast<int>(selectedPointCount);
+}
+
+namespace
+{
+
+/// Whether a chunk holds the vertex data of all its points
+bool hasVertexData(const PointCloudData& chunk)
+{
+    const std::size_t npoints = static_cast<std::size_t>(chunk.npoints);
+    if(chunk.format == VertexFormat::Float)
+        return static_cast<std::size_t>(chunk.positions.size()) >= 3 * npoints * sizeof(float) &&
+               static_cast<std::size_t>(chunk.colors.size()) >= 3 * npoints * sizeof(float);
+    return static_cast<std::size_t>(chunk.vertices.size()) >= npoints * static_cast<std::size_t>(vertexStride(chunk.format));
+}
+
+/// Object space position of a point, decoded like the vertex shaders do
+void decodePosition(const PointCloudData& chunk, std::size_t index, float position[3])
+{
+    if(chunk.format == VertexFormat::Float)
+    {
+        std::memcpy(position, chunk.positions.constData() + 3 * index * sizeof(float), 3 * sizeof(float));
+        return;
+    }
+    const char* vertex = chunk.vertices.constData() + index * static_cast<std::size_t>(vertexStride(chunk.format));
+    if(chunk.format == VertexFormat::Compact)
+    {
+        std::memcpy(position, vertex, 3 * sizeof(float));
+        return;
+    }
+    // Qt3D normalizes unsigned shorts to [0, 1]
+    uint16_t quantized[3];
+    std::memcpy(quantized, vertex, sizeof(quantized));
+    for(int k = 0; k < 3; ++k)
+        position[k] = quantized[k] / 65535.0f * chunk.quantizationScale[k] + chunk.quantizationOffset[k];
+}
+
+QVector3D decodeColor(const PointCloudData& chunk, std::size_t index)
+{
+    if(chunk.format == VertexFormat::Float)
+    {
+        const float* color = reinterpret_cast<const float*>(chunk.colors.constData()) + 3 * index;
+        return QVector3D(color[0], color[1], color[2]);
+    }
+    const auto* color = reinterpret_cast<const uint8_t*>(
+        chunk.vertices.constData() + index * static_cast<std::size_t>(vertexStride(chunk.format)) +
+        colorByteOffset(chunk.format));
+    return QVector3D(color[0], color[1], color[2]) / 255.0f;
+}
+
+} // namespace
+
+QVariantMap PointCloudEntity::pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const
+{
+    QVariantMap result;
+    if(!_pickingTree || _pointCount <= 0 || direction.isNull())
+        return result;
+    bool invertible = false;
+    const QMatrix4x4 world = worldMatrix();
+    const QMatrix4x4 toLocal = world.inverted(&invertible);
+    if(!invertible)
+        return result;
+
+    // the radius and the distance along the ray are scaled assuming a uniform scale
+    const QVector3D localOrigin = toLocal.map(origin);
+    const QVector3D localVector = toLocal.mapVector(direction.normalized());
+    const float scale = localVector.length();
+    const QVector3D localDirection = localVector / scale;
+    const float rayOrigin[3] = {localOrigin.x(), localOrigin.y(), localOrigin.z()};
+    const float rayDirection[3] = {localDirection.x(), localDirection.y(), localDirection.z()};
+    float distance = 0.0f;
+    const int64_t picked = _pickingTree->pick(rayOrigin, rayDirection, radius * scale, &distance);
+    if(picked < 0)
+        return result;
+
+    // find the chunk holding the point
+    std::size_t index = static_cast<std::size_t>(picked);
+    for(const auto& chunk : _chunks)
+    {
+        const std::size_t npoints = static_cast<std::size_t>(chunk.npoints);
+        if(index >= npoints)
+        {
+            index -= npoints;
+            continue;
+        }
+        if(!hasVertexData(chunk))
+            break;
+        float position[3];
+        decodePosition(chunk, index, position);
+        result.insert(QStringLiteral("index"), static_cast<qlonglong>(picked));
+        result.insert(QStringLiteral("position"), world.map(QVector3D(position[0], position[1], position[2])));
+        result.insert(QStringLiteral("color"), decodeColor(chunk, index));
+        result.insert(QStringLiteral("distance"), distance / scale);
+        break;
+    }
+    return result;
+}
 
 } // namespace
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "BaseAlembicObject.hpp"
+#include "PointKdTree.hpp"
+#include "SceneDescription.hpp"
+#include <Qt3DRender/QCamera>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
+#include <QVariantMap>
+#include <QVector>
+#include <memory>
 
 
 namespace abcentity
@@ -9,13 +17,68 @@ namespace abcentity
 class PointCloudEntity : public BaseAlembicObject
 {
     Q_OBJECT
+    /// Bounds of the points, in object space
+    Q_PROPERTY(abcentity::BoundingBox boundingBox READ boundingBox NOTIFY boundingBoxChanged)
 
 public:
     explicit PointCloudEntity(Qt3DCore::QNode* = nullptr);
     ~PointCloudEntity() override = default;
 
 public:
-    void setData(const Alembic::Abc::IObject&);
+    /// Create the geometry renderer from vertex data read by SceneReader
+    void setData(const PointCloudData& data);
+    /// Append a streamed chunk of vertex data, rendered as a separate buffer
+    void addChunk(const PointCloudData& data);
+    /// Remove all vertex data, e.g. before setting the data of another animation sample
+    void clearData();
+
+    /// Number of points uploaded so far
+    int pointCount() const { return _pointCount; }
+    const BoundingBox& boundingBox() const { return _boundingBox; }
+
+    Q_SIGNAL void boundingBoxChanged();
+
+    /// Whether this point cloud has been loaded with a level-of-detail octree
+    bool hasLevelOfDetail() const { return _octree != nullptr; }
+    /**
+     * @brief Enable the octree nodes to render from the given camera.
+     * @param camera the viewing camera, nodes are selected breadth first if null
+     * @param pointBudget maximum number of points to render (at least the root node), all nodes if <= 0
+     * @return the number of rendered points
+     */
+    int updateLevelOfDetail(const Qt3DRender::QCamera* camera, int pointBudget);
+
+    /**
+     * @brief Pick the first point along a ray, among the loaded points closer than radius to it.
+     *
+     * Points are only picked in point clouds loaded with a picking tree (see AlembicEntity::pointPicking).
+     * @param origin ray origin, in world coordinates
+     * @param direction ray direction, in world coordinates
+     * @param radius maximum distance of the points to the ray, in world units
+     * @return the point "index" in the loaded points, its world "position", "color" and
+     * "distance" along the ray, or an empty map if no point is picked
+     */
+    Q_INVOKABLE QVariantMap pickPoint(const QVector3D& origin, const QVector3D& direction, float radius) const;
+
+private:
+    void setBoundingBox(const BoundingBox& box);
+    /// Use a dedicated material decoding quantized positions
+    void setQuantization(const PointCloudData& data);
+    /// Create one child entity per octree node, sharing a single geometry
+    void createLevelOfDetail(const PointCloudData& data);
+
+private:
+    int _pointCount = 0;
+    BoundingBox _boundingBox;
+    std::shared_ptr<const PointOctree> _octree;
+    Qt3DRender::QMaterial* _quantizationMaterial = nullptr;
+    Qt3DRender::QParameter* _positionOffsetParameter = nullptr;
+    Qt3DRender::QParameter* _positionScaleParameter = nullptr;
+    QVector<Qt3DCore::QEntity*> _octreeNodeEntities;
+    /// Vertex data of the chunks, in point order, kept for picking
+    std::vector<PointCloudData> _chunks;
+    /// Tree built on the IO thread over the points of all chunks, null if not loaded for picking
+    std::shared_ptr<const PointKdTree> _pickingTree;
 };
 
 } // namespace
@@ -0,0 +1,226 @@
+#include "PointKdTree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace abcentity
+{
+
+void PointKdTree::build(const float* positions, std::size_t npoints, uint32_t leafSize, const ParallelFor& parallelFor)
+{
+    leafSize = std::max<uint32_t>(leafSize, 1);
+    _points.clear();
+    _nodes.clear();
+    // points are copied to be sorted in place, which is much faster than sorting indices
+    _points.reserve(npoints);
+    for(std::size_t i = 0; i < npoints; ++i)
+    {
+        const float* p = positions + 3 * i;
+        if(std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2]))
+            _points.push_back({{p[0], p[1], p[2]}, static_cast<uint32_t>(i)});
+    }
+    if(_points.empty())
+        return;
+
+    // a binary tree with leaves of about leafSize / 2 to leafSize points
+    _nodes.reserve(4 * (_points.size() / leafSize + 1));
+    Node root;
+    root.begin = 0;
+    root.end = static_cast<uint32_t>(_points.size());
+    root.children = -1;
+    _nodes.push_back(root);
+    if(!parallelFor)
+    {
+        buildSubtree(_nodes, 0, leafSize);
+        return;
+    }
+
+    // split the first levels breadth first, then build the subtrees concurrently in separate node arrays
+    const std::size_t subtreeCount = 64;
+    std::vector<int32_t> subtrees(1, 0);
+    for(std::size_t i = 0; i < subtrees.size() && subtrees.size() < subtreeCount; ++i)
+    {
+        const int32_t index = subtrees[i];
+        const uint32_t middle = splitNode(_nodes[index], leafSize);
+        if(middle == _nodes[index].end)
+            continue;
+        addChildren(_nodes, index, middle);
+        subtrees.push_back(_nodes[index].children);
+        subtrees.push_back(_nodes[index].children + 1);
+        // split nodes are no longer subtrees
+        subtrees[i] = -1;
+    }
+    subtrees.erase(std::remove(subtrees.begin(), subtrees.end(), -1), subtrees.end());
+    std::vector<std::vector<Node>> subtreeNodes(subtrees.size());
+    parallelFor(static_cast<int>(subtrees.size()), [&](int i) {
+        subtreeNodes[i].push_back(_nodes[subtrees[i]]);
+        buildSubtree(subtreeNodes[i], 0, leafSize);
+    });
+    for(std::size_t i = 0; i < subtrees.size(); ++i)
+    {
+        // node j > 0 of the subtree is appended at offset + j - 1, its root replacing the split node
+        const int32_t offset = static_cast<int32_t>(_nodes.size());
+        for(Node& node : subtreeNodes[i])
+        {
+            if(node.children >= 0)
+                node.children += offset - 1;
+        }
+        _nodes[subtrees[i]] = subtreeNodes[i][0];
+        _nodes.insert(_nodes.end(), subtreeNodes[i].begin() + 1, subtreeNodes[i].end());
+    }
+}
+
+uint32_t PointKdTree::splitNode(Node& node, uint32_t leafSize)
+{
+    float minCorner[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                          std::numeric_limits<float>::max()};
+    float maxCorner[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                          std::numeric_limits<float>::lowest()};
+    for(uint32_t i = node.begin; i < node.end; ++i)
+    {
+        const float* p = _points[i].position;
+        for(int k = 0; k < 3; ++k)
+        {
+            minCorner[k] = std::min(minCorner[k], p[k]);
+            maxCorner[k] = std::max(maxCorner[k], p[k]);
+        }
+    }
+    std::copy(minCorner, minCorner + 3, node.min);
+    std::copy(maxCorner, maxCorner + 3, node.max);
+    if(node.end - node.begin <= leafSize)
+        return node.end;
+
+    // split at the median of the largest axis
+    int axis = 0;
+    for(int k = 1; k < 3; ++k)
+    {
+        if(maxCorner[k] - minCorner[k] > maxCorner[axis] - minCorner[axis])
+            axis = k;
+    }
+    const uint32_t middle = node.begin + (node.end - node.begin) / 2;
+    std::nth_element(_points.begin() + node.begin, _points.begin() + middle, _points.begin() + node.end,
+                     [axis](const Point& a, const Point& b) { return a.position[axis] < b.position[axis]; });
+    return middle;
+}
+
+void PointKdTree::addChildren(std::vector<Node>& nodes, int32_t index, uint32_t middle)
+{
+    Node child;
+    child.children = -1;
+    child.begin = nodes[index].begin;
+    child.end = middle;
+    const uint32_t end = nodes[index].end;
+    nodes[index].children = static_cast<int32_t>(nodes.size());
+    nodes.push_back(child);
+    child.begin = middle;
+    child.end = end;
+    nodes.push_back(child);
+}
+
+void PointKdTree::buildSubtree(std::vector<Node>& nodes, int32_t index, uint32_t leafSize)
+{
+    // iterate on the second child to limit the recursion depth
+    while(true)
+    {
+        const uint32_t middle = splitNode(nodes[index], leafSize);
+        if(middle == nodes[index].end)
+            return;
+        addChildren(nodes, index, middle);
+        const int32_t children = nodes[index].children;
+        buildSubtree(nodes, children, leafSize);
+        index = children + 1;
+    }
+}
+
+float PointKdTree::enterDistance(const Node& node, const float origin[3], const float direction[3], float radius,
+                                 float maxDistance) const
+{
+    // slab test
+    float enter = 0.0f;
+    float exit = maxDistance;
+    for(int k = 0; k < 3; ++k)
+    {
+        const float low = node.min[k] - radius - origin[k];
+        const float high = node.max[k] + radius - origin[k];
+        if(direction[k] == 0.0f)
+        {
+            if(low > 0.0f || high < 0.0f)
+                return -1.0f;
+            continue;
+        }
+        float t0 = low / direction[k];
+        float t1 = high / direction[k];
+        if(t0 > t1)
+            std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        if(enter > exit)
+            return -1.0f;
+    }
+    return enter;
+}
+
+int64_t PointKdTree::pick(const float origin[3], const float direction[3], float radius, float* rayDistance) const
+{
+    if(_nodes.empty())
+        return -1;
+    const float radiusSquared = radius * radius;
+    float closest = std::numeric_limits<float>::max();
+    int64_t picked = -1;
+
+    // nodes to visit with the distance at which the ray enters them, nearest first
+    std::vector<std::pair<int32_t, float>> stack;
+    stack.reserve(64);
+    const float rootDistance = enterDistance(_nodes[0], origin, direction, radius, closest);
+    if(rootDistance >= 0.0f)
+        stack.push_back(std::make_pair(0, rootDistance));
+    while(!stack.empty())
+    {
+        const std::pair<int32_t, float> entry = stack.back();
+        stack.pop_back();
+        // points of a node are not before the ray enters its grown box
+        if(entry.second >= closest)
+            continue;
+        const Node& node = _nodes[entry.first];
+        if(node.children < 0)
+        {
+            for(uint32_t i = node.begin; i < node.end; ++i)
+            {
+                const float* p = _points[i].position;
+                const float v[3] = {p[0] - origin[0], p[1] - origin[1], p[2] - origin[2]};
+                const float t = v[0] * direction[0] + v[1] * direction[1] + v[2] * direction[2];
+                if(t < 0.0f || t >= closest)
+                    continue;
+                const float distanceSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] - t * t;
+                if(distanceSquared > radiusSquared)
+                    continue;
+                closest = t;
+                picked = _points[i].index;
+            }
+            continue;
+        }
+        const float first = enterDistance(_nodes[node.children], origin, direction, radius, closest);
+        const float second = enterDistance(_nodes[node.children + 1], origin, direction, radius, closest);
+        // push the farthest child first, to visit the nearest one first
+        const bool firstIsNearest = first >= 0.0f && (second < 0.0f || first <= second);
+        if(firstIsNearest)
+        {
+            if(second >= 0.0f)
+                stack.push_back(std::make_pair(node.children + 1, second));
+            stack.push_back(std::make_pair(node.children, first));
+        }
+        else
+        {
+            if(first >= 0.0f)
+                stack.push_back(std::make_pair(node.children, first));
+            if(second >= 0.0f)
+                stack.push_back(std::make_pair(node.children + 1, second));
+        }
+    }
+    if(picked >= 0 && rayDistance)
+        *rayDistance = closest;
+    return picked;
+}
+
+} // namespace
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace abcentity
+{
+
+/**
+ * @brief K-d tree over a point cloud, to pick points along a ray.
+ *
+ * Nodes are split at the median of their largest axis, down to leaves of a few points,
+ * and store the bounding box of their points. Non-finite points are ignored.
+ * This class does not depend on Qt and can be built on any thread; pick() can be
+ * called concurrently once built.
+ */
+class PointKdTree
+{
+public:
+    /// Call function(i) for each i in [0, count), possibly concurrently
+    using ParallelFor = std::function<void(int count, const std::function<void(int)>& function)>;
+
+    /// Build the tree over a copy of the given float32 XYZ positions, subtrees being built with parallelFor if set.
+    void build(const float* positions, std::size_t npoints, uint32_t leafSize = 16,
+               const ParallelFor& parallelFor = nullptr);
+
+    /**
+     * @brief Find the first point along a ray among those closer than radius to it.
+     * @param origin, direction the ray, direction being normalized
+     * @param radius maximum distance of the points to the ray
+     * @param rayDistance if not null, set to the distance along the ray of the picked point
+     * @return the index of the picked point in the input positions, -1 if none
+     */
+    int64_t pick(const float origin[3], const float direction[3], float radius, float* rayDistance = nullptr) const;
+
+    bool empty() const { return _nodes.empty(); }
+    /// Memory used by the tree, in bytes
+    std::size_t byteSize() const { return _nodes.size() * sizeof(Node) + _points.size() * sizeof(Point); }
+
+private:
+    struct Point
+    {
+        float position[3];
+        /// Index in the input positions
+        uint32_t index;
+    };
+
+    struct Node
+    {
+        float min[3];
+        float max[3];
+        /// Range of the points of this node in _points
+        uint32_t begin;
+        uint32_t end;
+        /// Index of the first child, the second one following it; -1 for leaves
+        int32_t children;
+    };
+
+    /// Compute the bounds of node and, unless it is a leaf, partition its points at the median of its largest axis.
+    /// Returns the first point of the second child, or node.end for leaves.
+    uint32_t splitNode(Node& node, uint32_t leafSize);
+    static void addChildren(std::vector<Node>& nodes, int32_t index, uint32_t middle);
+    /// Split nodes[index] and its descendants down to leaves, children being appended to nodes.
+    void buildSubtree(std::vector<Node>& nodes, int32_t index, uint32_t leafSize);
+    /// Distance along the ray where it enters the node box grown by radius, or a negative value if it misses
+    /// the box before maxDistance
+    float enterDistance(const Node& node, const float origin[3], const float direction[3], float radius,
+                        float maxDistance) const;
+
+private:
+    /// Points sorted by node
+    std::vector<Point> _points;
+    std::vector<Node> _nodes;
+};
+
+} // namespace
@@ -0,0 +1,243 @@
+#include "PointOctree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Index of a coordinate in a regular subdivision of [minValue, minValue + resolution * cellSize]
+inline int cellCoordinate(float value, float minValue, float cellSize, int resolution)
+{
+    const float f = (value - minValue) / cellSize;
+    // also handles NaN and infinite values
+    return (f > 0.0f) ? (f < static_cast<float>(resolution) ? static_cast<int>(f) : resolution - 1) : 0;
+}
+
+} // namespace
+
+void PointOctree::build(const float* positions, std::size_t npoints, const BuildParams& params)
+{
+    _positions = positions;
+    _params = params;
+    _params.nodeCapacity = std::max<uint32_t>(_params.nodeCapacity, 1);
+    _nodes.clear();
+    _order.resize(npoints);
+    std::iota(_order.begin(), _order.end(), 0u);
+    if(npoints == 0)
+        return;
+
+    // bounding cube of the finite positions
+    float minCorner[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                          std::numeric_limits<float>::max()};
+    float maxCorner[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                          std::numeric_limits<float>::lowest()};
+    for(std::size_t i = 0; i < npoints; ++i)
+    {
+        const float* p = positions + 3 * i;
+        if(!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2]))
+            continue;
+        for(int k = 0; k < 3; ++k)
+        {
+            minCorner[k] = std::min(minCorner[k], p[k]);
+            maxCorner[k] = std::max(maxCorner[k], p[k]);
+        }
+    }
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float halfSize = 0.0f;
+    if(minCorner[0] <= maxCorner[0])
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            center[k] = 0.5f * (minCorner[k] + maxCorner[k]);
+            halfSize = std::max(halfSize, 0.5f * (maxCorner[k] - minCorner[k]));
+        }
+    }
+    halfSize = std::max(halfSize, 1e-6f);
+
+    buildNode(0, static_cast<uint32_t>(npoints), center, halfSize, 0);
+    _positions = nullptr;
+}
+
+int32_t PointOctree::buildNode(uint32_t begin, uint32_t end, const float center[3], float halfSize, int depth)
+{
+    const int32_t index = static_cast<int32_t>(_nodes.size());
+    Node node;
+    std::copy(center, center + 3, node.center);
+    node.halfSize = halfSize;
+    node.first = begin;
+    node.count = end - begin;
+    std::fill(node.children, node.children + 8, -1);
+    node.depth = depth;
+    _nodes.push_back(node);
+
+    if(end - begin <= _params.nodeCapacity || depth >= _params.maxDepth)
+        return index;
+
+    // subsample: keep the first point falling in each cell of a regular grid
+    const int resolution = std::max(1, static_cast<int>(std::cbrt(static_cast<double>(_params.nodeCapacity))));
+    const float cellSize = 2.0f * halfSize / static_cast<float>(resolution);
+    float minCorner[3];
+    for(int k = 0; k < 3; ++k)
+        minCorner[k] = center[k] - halfSize;
+
+    std::vector<uint8_t> occupied(static_cast<std::size_t>(resolution) * resolution * resolution, 0);
+    uint32_t selectedEnd = begin;
+    for(uint32_t i = begin; i < end; ++i)
+    {
+        const float* p = _positions + 3 * static_cast<std::size_t>(_order[i]);
+        const std::size_t cell =
+            (static_cast<std::size_t>(cellCoordinate(p[2], minCorner[2], cellSize, resolution)) * resolution +
+             static_cast<std::size_t>(cellCoordinate(p[1], minCorner[1], cellSize, resolution))) * resolution +
+            static_cast<std::size_t>(cellCoordinate(p[0], minCorner[0], cellSize, resolution));
+        if(occupied[cell])
+            continue;
+        occupied[cell] = 1;
+        std::swap(_order[i], _order[selectedEnd++]);
+    }
+    _nodes[index].count = selectedEnd - begin;
+
+    // distribute the remaining points in octants (counting sort)
+    const uint32_t remaining = end - selectedEnd;
+    std::vector<uint8_t> octants(remaining);
+    uint32_t counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for(uint32_t i = 0; i < remaining; ++i)
+    {
+        const float* p = _positions + 3 * static_cast<std::size_t>(_order[selectedEnd + i]);
+        const uint8_t octant = static_cast<uint8_t>((p[0] >= center[0] ? 1 : 0) |
+                                                    (p[1] >= center[1] ? 2 : 0) |
+                                                    (p[2] >= center[2] ? 4 : 0));
+        octants[i] = octant;
+        ++counts[octant];
+    }
+    uint32_t offsets[8];
+    offsets[0] = 0;
+    for(int o = 1; o < 8; ++o)
+        offsets[o] = offsets[o - 1] + counts[o - 1];
+
+    std::vector<uint32_t> sorted(remaining);
+    uint32_t cursors[8];
+    std::copy(offsets, offsets + 8, cursors);
+    for(uint32_t i = 0; i < remaining; ++i)
+        sorted[cursors[octants[i]]++] = _order[selectedEnd + i];
+    std::copy(sorted.begin(), sorted.end(), _order.begin() + selectedEnd);
+
+    // free temporary buffers before recursing
+    std::vector<uint8_t>().swap(octants);
+    std::vector<uint32_t>().swap(sorted);
+
+    const float childHalfSize = 0.5f * halfSize;
+    for(int o = 0; o < 8; ++o)
+    {
+        if(counts[o] == 0)
+            continue;
+        const float childCenter[3] = {center[0] + ((o & 1) ? childHalfSize : -childHalfSize),
+                                      center[1] + ((o & 2) ? childHalfSize : -childHalfSize),
+                                      center[2] + ((o & 4) ? childHalfSize : -childHalfSize)};
+        const uint32_t childBegin = selectedEnd + offsets[o];
+        const int32_t child = buildNode(childBegin, childBegin + counts[o], childCenter, childHalfSize, depth + 1);
+        _nodes[index].children[o] = child;
+    }
+    return index;
+}
+
+bool PointOctree::isCulled(const Node& node, const float* planes) const
+{
+    if(!planes)
+        return false;
+    const float radius = node.halfSize * 1.7320508f;
+    for(int i = 0; i < 6; ++i)
+    {
+        const float* plane = planes + 4 * i;
+        const float distance = plane[0] * node.center[0] + plane[1] * node.center[1] +
+                               plane[2] * node.center[2] + plane[3];
+        if(distance < -radius)
+            return true;
+    }
+    return false;
+}
+
+std::vector<int> PointOctree::select(const SelectParams& params, std::size_t* selectedPointCount) const
+{
+    std::vector<int> selected;
+    std::size_t total = 0;
+
+    // projected size of the node bounding sphere, or breadth first order without eye
+    const auto priority = [&params](const Node& node) -> float {
+        if(!params.eye)
+            return -static_cast<float>(node.depth);
+        const float radius = node.halfSize * 1.7320508f;
+        const float dx = node.center[0] - params.eye[0];
+        const float dy = node.center[1] - params.eye[1];
+        const float dz = node.center[2] - params.eye[2];
+        const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if(distance <= radius)
+            return std::numeric_limits<float>::max();
+        return params.projectionScale * radius / distance;
+    };
+
+    typedef std::pair<float, int32_t> Entry;
+    std::priority_queue<Entry> queue;
+    if(!_nodes.empty() && !isCulled(_nodes[0], params.frustumPlanes))
+        queue.push(Entry(priority(_nodes[0]), 0));
+
+    while(!queue.empty())
+    {
+        const int32_t index = queue.top().second;
+        queue.pop();
+        const Node& node = _nodes[index];
+        // the root is always selected, so that point clouds with a small share of a budget remain visible
+        if(index != 0 && params.pointBudget > 0 && total + node.count > params.pointBudget)
+            break;
+        selected.push_back(index);
+        total += node.count;
+        for(int o = 0; o < 8; ++o)
+        {
+            const int32_t child = node.children[o];
+            if(child < 0 || isCulled(_nodes[child], params.frustumPlanes))
+                continue;
+            queue.push(Entry(priority(_nodes[child]), child));
+        }
+    }
+
+    if(selectedPointCount)
+        *selectedPointCount = total;
+    return selected;
+}
+
+void PointOctree::extractFrustumPlanes(const float* m, float* planes)
+{
+    // rows of the column-major matrix
+    const float row0[4] = {m[0], m[4], m[8], m[12]};
+    const float row1[4] = {m[1], m[5], m[9], m[13]};
+    const float row2[4] = {m[2], m[6], m[10], m[14]};
+    const float row3[4] = {m[3], m[7], m[11], m[15]};
+    const float* rows[3] = {row0, row1, row2};
+
+    for(int i = 0; i < 3; ++i)
+    {
+        for(int k = 0; k < 4; ++k)
+        {
+            planes[8 * i + k] = row3[k] + rows[i][k];
+            planes[8 * i + 4 + k] = row3[k] - rows[i][k];
+        }
+    }
+    // normalize so that plane distances are euclidean
+    for(int i = 0; i < 6; ++i)
+    {
+        float* plane = planes + 4 * i;
+        const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if(length <= 0.0f)
+            continue;
+        for(int k = 0; k < 4; ++k)
+            plane[k] /= length;
+    }
+}
+
+} // namespace
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace abcentity
+{
+
+/**
+ * @brief Level-of-detail octree over a point cloud.
+ *
+ * Each node stores a spatially subsampled representative subset of the points
+ * falling in its cell, the remaining points being distributed to its children.
+ * Point subsets are disjoint: rendering a node and all its ancestors gives a
+ * denser version of the cloud in this cell.
+ *
+ * Points are reordered so that each node references a contiguous range.
+ * This class does not depend on Qt and can be built on any thread.
+ */
+class PointOctree
+{
+public:
+    struct Node
+    {
+        /// Center of the node cube
+        float center[3];
+        /// Half size of the node cube
+        float halfSize;
+        /// Index of the first point of this node in the reordered points
+        uint32_t first;
+        /// Number of points in this node
+        uint32_t count;
+        /// Child node indices, -1 if empty
+        int32_t children[8];
+        int32_t depth;
+    };
+
+    struct BuildParams
+    {
+        /// Maximum number of points kept in a single node
+        uint32_t nodeCapacity = 50000;
+        /// Maximum depth of the tree
+        int maxDepth = 16;
+    };
+
+    struct SelectParams
+    {
+        /// Camera position in the point cloud frame; if null, nodes are selected breadth first
+        const float* eye = nullptr;
+        /// Frustum planes (6 x [a, b, c, d]) in the point cloud frame; if null, no culling
+        const float* frustumPlanes = nullptr;
+        /// Scale factor from view-space size to screen size (e.g. projection[1][1])
+        float projectionScale = 1.0f;
+        /// Maximum number of points to select, exceeded by the root node alone if it is larger; 0 for no limit
+        std::size_t pointBudget = 0;
+    };
+
+    /// Build the octree over the given float32 XYZ positions.
+    void build(const float* positions, std::size_t npoints, const BuildParams& params);
+
+    /// Select nodes by decreasing projected size until the point budget is reached.
+    /// Parents are always selected before their children, and the root unless it is culled.
+    std::vector<int> select(const SelectParams& params, std::size_t* selectedPointCount = nullptr) const;
+
+    /// Nodes of the tree, the first one being the root.
+    const std::vector<Node>& nodes() const { return _nodes; }
+    /// order()[i] is the index in the input positions of the i-th reordered point.
+    const std::vector<uint32_t>& order() const { return _order; }
+
+    /// Extract the 6 frustum planes of a column-major view-projection matrix.
+    static void extractFrustumPlanes(const float* matrix, float* planes);
+
+private:
+    int32_t buildNode(uint32_t begin, uint32_t end, const float center[3], float halfSize, int depth);
+    bool isCulled(const Node& node, const float* planes) const;
+
+private:
+    const float* _positions = nullptr;
+    BuildParams _params;
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _order;
+};
+
+} // namespace
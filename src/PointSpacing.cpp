@@ -0,0 +1,225 @@
+#include "PointSpacing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Cells per axis, so that cell coordinates fit in 21 bits
+const int kResolution = 1 << 21;
+/// Neighbours are searched up to this number of cells away
+const int kMaxRing = 3;
+/// Key of the points without cell
+const uint64_t kInvalidKey = std::numeric_limits<uint64_t>::max();
+
+inline bool isFinite(const float* p)
+{
+    return std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2]);
+}
+
+inline int cellCoordinate(float value, float minValue, float cellSize)
+{
+    const float f = (value - minValue) / cellSize;
+    return f > 0.0f ? (f < static_cast<float>(kResolution - 1) ? static_cast<int>(f) : kResolution - 1) : 0;
+}
+
+} // namespace
+
+void PointSpacing::build(const float* positions, std::size_t npoints, int neighbourCount)
+{
+    _positions = positions;
+    _npoints = npoints;
+    _neighbourCount = std::max(neighbourCount, 1);
+    _sorted.clear();
+    _cellSize = 0.0f;
+
+    float maxCorner[3];
+    for(int k = 0; k < 3; ++k)
+    {
+        _minCorner[k] = std::numeric_limits<float>::max();
+        maxCorner[k] = std::numeric_limits<float>::lowest();
+    }
+    std::size_t finiteCount = 0;
+    for(std::size_t i = 0; i < npoints; ++i)
+    {
+        const float* p = positions + 3 * i;
+        if(!isFinite(p))
+            continue;
+        ++finiteCount;
+        for(int k = 0; k < 3; ++k)
+        {
+            _minCorner[k] = std::min(_minCorner[k], p[k]);
+            maxCorner[k] = std::max(maxCorner[k], p[k]);
+        }
+    }
+
+    // first guess: points filling the bounding cube, then adjust the cell size to the occupancy of the cells
+    // assuming the points lie on a surface (e.g. a scan), so that cells hold about neighbourCount points
+    double maxExtent = 0.0;
+    for(int k = 0; finiteCount >= 2 && k < 3; ++k)
+        maxExtent = std::max(maxExtent, static_cast<double>(maxCorner[k]) - _minCorner[k]);
+    if(maxExtent <= 0.0)
+    {
+        // less than two distinct positions: points have no cell, and a spacing of 0
+        _sorted.resize(npoints);
+        for(std::size_t i = 0; i < npoints; ++i)
+            _sorted[i] = std::make_pair(kInvalidKey, static_cast<uint32_t>(i));
+        return;
+    }
+    const double minCellSize = maxExtent / (kResolution - 1);
+    double cellSize = maxExtent / std::cbrt(static_cast<double>(finiteCount) / _neighbourCount);
+    for(int iteration = 0; iteration < 4; ++iteration)
+    {
+        _cellSize = static_cast<float>(std::max(cellSize, minCellSize));
+        const std::size_t occupiedCells = sortPoints();
+        const double occupancy = static_cast<double>(finiteCount) / static_cast<double>(std::max<std::size_t>(occupiedCells, 1));
+        if(occupancy >= 0.5 * _neighbourCount && occupancy <= 2.0 * _neighbourCount)
+            break;
+        cellSize *= std::sqrt(_neighbourCount / occupancy);
+    }
+}
+
+std::size_t PointSpacing::sortPoints()
+{
+    _sorted.resize(_npoints);
+    for(std::size_t i = 0; i < _npoints; ++i)
+    {
+        const float* p = _positions + 3 * i;
+        const uint64_t key = isFinite(p) ? cellKey(cellCoordinate(p[0], _minCorner[0], _cellSize),
+                                                   cellCoordinate(p[1], _minCorner[1], _cellSize),
+                                                   cellCoordinate(p[2], _minCorner[2], _cellSize))
+                                         : kInvalidKey;
+        _sorted[i] = std::make_pair(key, static_cast<uint32_t>(i));
+    }
+    std::sort(_sorted.begin(), _sorted.end());
+    // copy positions in cell order, for neighbour searches to read contiguous memory
+    _sortedPositions.resize(3 * _npoints);
+    for(std::size_t i = 0; i < _npoints; ++i)
+        std::copy(_positions + 3 * static_cast<std::size_t>(_sorted[i].second),
+                  _positions + 3 * static_cast<std::size_t>(_sorted[i].second) + 3, _sortedPositions.data() + 3 * i);
+    std::size_t occupiedCells = 0;
+    for(std::size_t i = 0; i < _sorted.size() && _sorted[i].first != kInvalidKey; ++i)
+    {
+        if(i == 0 || _sorted[i].first != _sorted[i - 1].first)
+            ++occupiedCells;
+    }
+    return occupiedCells;
+}
+
+uint64_t PointSpacing::cellKey(int x, int y, int z) const
+{
+    return static_cast<uint64_t>(x) | (static_cast<uint64_t>(y) << 21) | (static_cast<uint64_t>(z) << 42);
+}
+
+std::size_t PointSpacing::lowerBound(uint64_t key) const
+{
+    return static_cast<std::size_t>(
+        std::lower_bound(_sorted.begin(), _sorted.end(), std::make_pair(key, uint32_t(0))) - _sorted.begin());
+}
+
+void PointSpacing::ringRows(const int cell[3], int ring, std::vector<std::pair<std::size_t, std::size_t>>& rows) const
+{
+    const auto addRow = [&](int firstX, int lastX, int y, int z) {
+        firstX = std::max(firstX, 0);
+        lastX = std::min(lastX, kResolution - 1);
+        const std::size_t begin = lowerBound(cellKey(firstX, y, z));
+        const std::size_t end = lowerBound(cellKey(lastX, y, z) + 1);
+        if(begin < end)
+            rows.push_back(std::make_pair(begin, end));
+    };
+    for(int z = std::max(cell[2] - ring, 0); z <= std::min(cell[2] + ring, kResolution - 1); ++z)
+    {
+        for(int y = std::max(cell[1] - ring, 0); y <= std::min(cell[1] + ring, kResolution - 1); ++y)
+        {
+            if(std::abs(y - cell[1]) == ring || std::abs(z - cell[2]) == ring)
+            {
+                // whole row of the ring: cells of consecutive x are contiguous in the sorted points
+                addRow(cell[0] - ring, cell[0] + ring, y, z);
+            }
+            else
+            {
+                addRow(cell[0] - ring, cell[0] - ring, y, z);
+                if(ring > 0)
+                    addRow(cell[0] + ring, cell[0] + ring, y, z);
+            }
+        }
+    }
+}
+
+void PointSpacing::addNeighbours(std::size_t point, const std::vector<std::pair<std::size_t, std::size_t>>& rows,
+                                 std::vector<float>& nearest) const
+{
+    const float* p = _sortedPositions.data() + 3 * point;
+    for(const auto& row : rows)
+    {
+        for(std::size_t j = row.first; j < row.second; ++j)
+        {
+            if(j == point)
+                continue;
+            const float* q = _sortedPositions.data() + 3 * j;
+            const float dx = q[0] - p[0], dy = q[1] - p[1], dz = q[2] - p[2];
+            const float d2 = dx * dx + dy * dy + dz * dz;
+            if(nearest.size() == static_cast<std::size_t>(_neighbourCount) && d2 >= nearest.back())
+                continue;
+            nearest.insert(std::upper_bound(nearest.begin(), nearest.end(), d2), d2);
+            if(nearest.size() > static_cast<std::size_t>(_neighbourCount))
+                nearest.pop_back();
+        }
+    }
+}
+
+void PointSpacing::estimate(std::size_t first, std::size_t last, float* spacing) const
+{
+    last = std::min(last, _sorted.size());
+    // squared distances to the nearest neighbours found so far, sorted
+    std::vector<float> nearest;
+    nearest.reserve(static_cast<std::size_t>(_neighbourCount) + 1);
+    std::vector<std::pair<std::size_t, std::size_t>> nearRows, ringRowsBuffer;
+    const float maxDistance = kMaxRing * _cellSize;
+    uint64_t currentKey = kInvalidKey;
+    for(std::size_t i = first; i < last; ++i)
+    {
+        const uint32_t point = _sorted[i].second;
+        const uint64_t key = _sorted[i].first;
+        if(key == kInvalidKey)
+        {
+            spacing[point] = 0.0f;
+            continue;
+        }
+        const float* p = _sortedPositions.data() + 3 * i;
+        const int cell[3] = {cellCoordinate(p[0], _minCorner[0], _cellSize),
+                             cellCoordinate(p[1], _minCorner[1], _cellSize),
+                             cellCoordinate(p[2], _minCorner[2], _cellSize)};
+        // points of a cell share the rows of the 3x3x3 cells around it
+        if(key != currentKey)
+        {
+            currentKey = key;
+            nearRows.clear();
+            ringRows(cell, 0, nearRows);
+            ringRows(cell, 1, nearRows);
+        }
+        nearest.clear();
+        addNeighbours(i, nearRows, nearest);
+        // sparse areas: search further rings until enough neighbours are found (approximate: neighbours of
+        // the next ring may be closer than the farthest ones found, but by less than a cell)
+        for(int ring = 2; ring <= kMaxRing && nearest.size() < static_cast<std::size_t>(_neighbourCount); ++ring)
+        {
+            ringRowsBuffer.clear();
+            ringRows(cell, ring, ringRowsBuffer);
+            addNeighbours(i, ringRowsBuffer, nearest);
+        }
+        // neighbours not found are far away
+        float sum = 0.0f;
+        for(float d2 : nearest)
+            sum += std::min(std::sqrt(d2), maxDistance);
+        sum += maxDistance * static_cast<float>(_neighbourCount - static_cast<int>(nearest.size()));
+        spacing[point] = sum / static_cast<float>(_neighbourCount);
+    }
+}
+
+} // namespace
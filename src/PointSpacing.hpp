@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace abcentity
+{
+
+/**
+ * @brief Estimate the local spacing of a point cloud from the distances to the nearest neighbours of each point.
+ *
+ * Points are indexed in a uniform grid sized for a few neighbours per occupied cell; neighbours
+ * are searched in rings of cells around each point, up to a few cells away.
+ * This class does not depend on Qt, and estimate() can be called concurrently on disjoint ranges.
+ */
+class PointSpacing
+{
+public:
+    /// Index the given float32 XYZ positions, which must outlive this object.
+    void build(const float* positions, std::size_t npoints, int neighbourCount);
+
+    /// Number of points, to be split into ranges for estimate() (all points, including non-finite ones)
+    std::size_t size() const { return _sorted.size(); }
+    /**
+     * @brief Estimate the spacing of a range of the points, processed by cell for locality.
+     * @param first, last range of the points sorted by cell (not of the input positions)
+     * @param spacing output, the mean distance of each point to its nearest neighbours being written
+     *        at its index in the input positions (0 for non-finite points)
+     */
+    void estimate(std::size_t first, std::size_t last, float* spacing) const;
+
+    float cellSize() const { return _cellSize; }
+
+private:
+    /// Sort points by cell, returning the number of occupied cells
+    std::size_t sortPoints();
+    uint64_t cellKey(int x, int y, int z) const;
+    /// Index of the first sorted point of a cell, or of the next cell if empty
+    std::size_t lowerBound(uint64_t key) const;
+    /// Append the ranges of sorted points of the cells at the given Chebyshev distance from cell
+    void ringRows(const int cell[3], int ring, std::vector<std::pair<std::size_t, std::size_t>>& rows) const;
+    /// Insert the squared distances from a sorted point to the points of rows into the sorted nearest ones
+    void addNeighbours(std::size_t point, const std::vector<std::pair<std::size_t, std::size_t>>& rows,
+                       std::vector<float>& nearest) const;
+
+private:
+    const float* _positions = nullptr;
+    std::size_t _npoints = 0;
+    int _neighbourCount = 8;
+    float _minCorner[3] = {0.0f, 0.0f, 0.0f};
+    float _cellSize = 0.0f;
+    /// Cell key and index of the points, sorted by key
+    std::vector<std::pair<uint64_t, uint32_t>> _sorted;
+    /// Positions of the sorted points
+    std::vector<float> _sortedPositions;
+};
+
+} // namespace
@@ -0,0 +1,105 @@
+#include "SampleThread.hpp"
+
+namespace abcentity
+{
+
+SampleThread::~SampleThread()
+{
+    stop();
+}
+
+void SampleThread::setAnimation(const std::shared_ptr<SceneAnimation>& animation)
+{
+    {
+        QMutexLocker lock(&_mutex);
+        _animation = animation;
+        _hasRequest = false;
+        _stopped = false;
+        _sample.reset();
+    }
+    if(animation && !isRunning())
+        start();
+}
+
+void SampleThread::request(double time, int prefetchCount)
+{
+    QMutexLocker lock(&_mutex);
+    _requestTime = time;
+    _prefetchCount = prefetchCount;
+    _hasRequest = true;
+    _condition.wakeOne();
+}
+
+std::shared_ptr<const SceneSample> SampleThread::takeSample()
+{
+    QMutexLocker lock(&_mutex);
+    std::shared_ptr<const SceneSample> sample;
+    sample.swap(_sample);
+    return sample;
+}
+
+void SampleThread::stop()
+{
+    {
+        QMutexLocker lock(&_mutex);
+        _stopped = true;
+        _condition.wakeOne();
+    }
+    wait();
+}
+
+void SampleThread::run()
+{
+    for(;;)
+    {
+        std::shared_ptr<SceneAnimation> animation;
+        double time = 0.0;
+        int prefetchCount = 0;
+        {
+            QMutexLocker lock(&_mutex);
+            while(!_hasRequest && !_stopped)
+                _condition.wait(&_mutex);
+            if(_stopped)
+                return;
+            animation = _animation;
+            time = _requestTime;
+            prefetchCount = _prefetchCount;
+            _hasRequest = false;
+        }
+        if(!animation)
+            continue;
+
+        try
+        {
+            std::shared_ptr<const SceneSample> sample = animation->sample(time);
+            {
+                QMutexLocker lock(&_mutex);
+                if(animation != _animation)
+                    continue;
+                _sample = sample;
+            }
+            Q_EMIT sampleReady();
+
+            // prefetch the next frames, unless a new request arrives
+            const double frameDuration = 1.0 / animation->frameRate();
+            for(int i = 1; i <= prefetchCount; ++i)
+            {
+                const double nextTime = time + i * frameDuration;
+                if(nextTime > animation->endTime() + 0.5 * frameDuration)
+                    break;
+                {
+                    QMutexLocker lock(&_mutex);
+                    if(_hasRequest || _stopped)
+                        break;
+                }
+                animation->sample(nextTime);
+            }
+        }
+        catch(...)
+        {
+            // keep the previous sample on read errors
+        }
+    }
+}
+
+}
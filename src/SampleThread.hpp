@@ -0,0 +1,51 @@
+#pragma once
+
+#include "SceneAnimation.hpp"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <memory>
+
+namespace abcentity
+{
+
+/**
+ * @brief Read animation samples in a separate thread.
+ *
+ * Reads the last requested time, then prefetches the following frames
+ * into the SceneAnimation cache until a new request arrives.
+ */
+class SampleThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    ~SampleThread() override;
+
+    /// Set the animation to sample, discarding pending requests. Starts the thread main loop.
+    void setAnimation(const std::shared_ptr<SceneAnimation>& animation);
+    /// Request the sample at the given time, then prefetch the next prefetchCount frames.
+    void request(double time, int prefetchCount);
+    /// Take the last sample read (nullptr if none).
+    std::shared_ptr<const SceneSample> takeSample();
+    /// Stop the thread main loop and wait for it to finish.
+    void stop();
+    /// Thread main loop.
+    void run() override;
+
+public:
+    /// Emitted from the sampling thread when a requested sample is available.
+    Q_SIGNAL void sampleReady();
+
+private:
+    QMutex _mutex;
+    QWaitCondition _condition;
+    std::shared_ptr<SceneAnimation> _animation;
+    bool _hasRequest = false;
+    bool _stopped = false;
+    double _requestTime = 0.0;
+    int _prefetchCount = 0;
+    std::shared_ptr<const SceneSample> _sample;
+};
+
+}
@@ -0,0 +1,139 @@
+#include "SceneAnimation.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Samples are requested from frame numbers: compare times with a tolerance
+inline bool isSameTime(double a, double b)
+{
+    return std::abs(a - b) < 1e-6;
+}
+
+} // namespace
+
+std::size_t SceneSample::byteSize() const
+{
+    std::size_t size = sizeof(SceneSample) + matrices.size() * sizeof(QMatrix4x4);
+    for(const auto& data : pointClouds)
+        size += data.byteSize();
+    return size;
+}
+
+SceneAnimation::SceneAnimation(const LoadOptions& options)
+{
+    setLoadOptions(options);
+}
+
+void SceneAnimation::setLoadOptions(const LoadOptions& options)
+{
+    _options = options;
+    // samples are read after the load, which may be cancelled by the next one
+    _options.cancelled = nullptr;
+    _options.statistics.reset();
+}
+
+void SceneAnimation::addTransformTrack(const TransformTrack& track)
+{
+    _transformTracks.push_back(track);
+}
+
+void SceneAnimation::addPointsTrack(const PointsTrack& track)
+{
+    _pointsTracks.push_back(track);
+}
+
+void SceneAnimation::addTimeSampling(const Alembic::AbcCoreAbstract::TimeSamplingPtr& timeSampling,
+                                     std::size_t numSamples)
+{
+    if(!timeSampling || numSamples == 0)
+        return;
+    const double start = timeSampling->getSampleTime(0);
+    const double end = timeSampling->getSampleTime(numSamples - 1);
+    _startTime = _hasTimeRange ? std::min(_startTime, start) : start;
+    _endTime = _hasTimeRange ? std::max(_endTime, end) : end;
+    _hasTimeRange = true;
+    const auto& samplingType = timeSampling->getTimeSamplingType();
+    if(_frameRate <= 0.0 && samplingType.isUniform() && samplingType.getTimePerCycle() > 0.0)
+        _frameRate = 1.0 / samplingType.getTimePerCycle();
+}
+
+std::shared_ptr<const SceneSample> SceneAnimation::sample(double time)
+{
+    std::shared_ptr<const SceneSample> result = cachedSample(time);
+    if(result)
+        return result;
+
+    // decode outside of the lock, so that cached samples remain available meanwhile
+    result = readSample(time);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // another thread may have read the same sample in the meantime
+    std::shared_ptr<const SceneSample> cached = findInCache(time);
+    if(cached)
+        return cached;
+    _cache.push_front(result);
+    _cacheBytes += result->byteSize();
+    // evict least recently used samples, always keeping the new one
+    while(_cacheBytes > _maxCacheBytes && _cache.size() > 1)
+    {
+        _cacheBytes -= _cache.back()->byteSize();
+        _cache.pop_back();
+    }
+    return result;
+}
+
+std::shared_ptr<const SceneSample> SceneAnimation::cachedSample(double time)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return findInCache(time);
+}
+
+void SceneAnimation::setCacheSize(std::size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxCacheBytes = maxBytes;
+    while(_cacheBytes > _maxCacheBytes && !_cache.empty())
+    {
+        _cacheBytes -= _cache.back()->byteSize();
+        _cache.pop_back();
+    }
+}
+
+std::shared_ptr<const SceneSample> SceneAnimation::findInCache(double time)
+{
+    for(auto it = _cache.begin(); it != _cache.end(); ++it)
+    {
+        if(!isSameTime((*it)->time, time))
+            continue;
+        _cache.splice(_cache.begin(), _cache, it);
+        return _cache.front();
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const SceneSample> SceneAnimation::readSample(double time) const
+{
+    std::shared_ptr<SceneSample> result = std::make_shared<SceneSample>();
+    result->time = time;
+    result->matrices.reserve(_transformTracks.size());
+    for(const auto& track : _transformTracks)
+    {
+        QMatrix4x4 matrix;
+        for(const auto& xform : track.xforms)
+            matrix = matrix * SceneReader::readMatrix(xform, time);
+        result->matrices.push_back(matrix);
+    }
+
+    const SceneReader reader(_options);
+    result->pointClouds.reserve(_pointsTracks.size());
+    for(const auto& track : _pointsTracks)
+        result->pointClouds.push_back(reader.readPointCloud(track.points, time));
+    return result;
+}
+
+} // namespace
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "SceneReader.hpp"
+#include <QMatrix4x4>
+#include <QString>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace abcentity
+{
+
+/// Values of the animated objects of a scene at a given time
+struct SceneSample
+{
+    double time = 0.0;
+    /// Matrices, in the order of SceneAnimation::transformTracks()
+    std::vector<QMatrix4x4> matrices;
+    /// Vertex data, in the order of SceneAnimation::pointsTracks()
+    std::vector<PointCloudData> pointClouds;
+
+    /// Approximate memory used by this sample, in bytes
+    std::size_t byteSize() const;
+};
+
+/**
+ * @brief Time-varying objects of an archive, sampled on demand.
+ *
+ * Decoded samples are kept in a bounded LRU cache. All methods are thread-safe,
+ * so that samples can be prefetched on a worker thread.
+ */
+class SceneAnimation
+{
+public:
+    struct TransformTrack
+    {
+        enum class Space
+        {
+            /// Local matrix of an Xform entity
+            Local = 0,
+            /// Matrix relative to the archive root of a point cloud, camera or mesh with animated ancestors
+            World
+        };
+        Space space = Space::Local;
+        QString path;
+        /// Xforms whose product gives the matrix, outermost first
+        std::vector<Alembic::AbcGeom::IXform> xforms;
+    };
+
+    struct PointsTrack
+    {
+        QString path;
+        Alembic::AbcGeom::IPoints points;
+    };
+
+    explicit SceneAnimation(const LoadOptions& options);
+
+    /// Options used to read samples
+    void setLoadOptions(const LoadOptions& options);
+
+    void addTransformTrack(const TransformTrack& track);
+    void addPointsTrack(const PointsTrack& track);
+    /// Extend the time range with the samples of an animated property
+    void addTimeSampling(const Alembic::AbcCoreAbstract::TimeSamplingPtr& timeSampling, std::size_t numSamples);
+
+    const std::vector<TransformTrack>& transformTracks() const { return _transformTracks; }
+    const std::vector<PointsTrack>& pointsTracks() const { return _pointsTracks; }
+    bool isEmpty() const { return _transformTracks.empty() && _pointsTracks.empty(); }
+    /// Whether the hierarchy of the animated scene was flattened, World tracks then moving the flattened objects
+    bool isFlattened() const { return _options.flattenHierarchy; }
+
+    /// Time of the first sample, in seconds
+    double startTime() const { return _startTime; }
+    /// Time of the last sample, in seconds
+    double endTime() const { return _endTime; }
+    /// Frames per second of the first uniformly sampled track (24 if unknown)
+    double frameRate() const { return _frameRate > 0.0 ? _frameRate : 24.0; }
+
+    /// Sample at the given time, read from the archive if not cached.
+    std::shared_ptr<const SceneSample> sample(double time);
+    /// Cached sample at the given time, nullptr if not in cache.
+    std::shared_ptr<const SceneSample> cachedSample(double time);
+    /// Maximum memory used by cached samples, in bytes
+    void setCacheSize(std::size_t maxBytes);
+
+private:
+    std::shared_ptr<const SceneSample> readSample(double time) const;
+    /// Find a cached sample and mark it as most recently used (requires _mutex)
+    std::shared_ptr<const SceneSample> findInCache(double time);
+
+private:
+    LoadOptions _options;
+    std::vector<TransformTrack> _transformTracks;
+    std::vector<PointsTrack> _pointsTracks;
+    double _startTime = 0.0;
+    double _endTime = 0.0;
+    double _frameRate = 0.0;
+    bool _hasTimeRange = false;
+
+    std::mutex _mutex;
+    /// Most recently used first
+    std::list<std::shared_ptr<const SceneSample>> _cache;
+    std::size_t _cacheBytes = 0;
+    std::size_t _maxCacheBytes = 512 * 1024 * 1024;
+};
+
+} // namespace
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "AlembicProperties.hpp"
+#include "BoundingBox.hpp"
+#include "PointKdTree.hpp"
+#include "PointOctree.hpp"
+#include <QByteArray>
+#include <QHash>
+#include <QMatrix4x4>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <memory>
+#include <vector>
+
+namespace abcentity
+{
+
+class SceneAnimation;
+
+/// Keeps alive memory referenced by raw QByteArrays (see QByteArray::fromRawData).
+using DataOwner = std::shared_ptr<const void>;
+
+/// Wrap any copyable owner of memory (e.g. an Alembic ArraySamplePtr or a QByteArray) into a DataOwner.
+template<typename T>
+DataOwner makeDataOwner(const T& owner)
+{
+    return std::make_shared<T>(owner);
+}
+
+/// Child object keeping DataOwners alive as long as its parent, e.g. a Qt3D buffer referencing their memory.
+class DataOwnerHolder : public QObject
+{
+public:
+    DataOwnerHolder(std::vector<DataOwner> owners, QObject* parent)
+        : QObject(parent)
+        , _owners(std::move(owners))
+    {
+    }
+
+    /// Keep owners alive as long as object
+    static void attach(QObject* object, const std::vector<DataOwner>& owners)
+    {
+        if(!owners.empty())
+            new DataOwnerHolder(owners, object);
+    }
+
+private:
+    std::vector<DataOwner> _owners;
+};
+
+/// Layout of point cloud vertex buffers
+enum class VertexFormat
+{
+    /// Separate float32 XYZ positions and float32 RGB colors buffers (24 bytes per point)
+    Float = 0,
+    /// Interleaved float32 XYZ positions and RGBA8 colors (16 bytes per point)
+    Compact,
+    /// Interleaved 16-bit XYZ positions relative to the bounding box and RGBA8 colors (12 bytes per point)
+    Quantized
+};
+
+/// Size in bytes of a vertex in the buffer holding positions
+inline int vertexStride(VertexFormat format)
+{
+    switch(format)
+    {
+    case VertexFormat::Compact:
+        return 16;
+    case VertexFormat::Quantized:
+        return 12;
+    case VertexFormat::Float:
+    default:
+        return 3 * static_cast<int>(sizeof(float));
+    }
+}
+
+/// Byte offset of the color in interleaved vertices
+inline int colorByteOffset(VertexFormat format)
+{
+    return format == VertexFormat::Quantized ? 8 : 12;
+}
+
+/**
+ * @brief Vertex data of a point cloud, ready to be uploaded to Qt3D buffers.
+ *
+ * Buffers may reference memory they do not own without copying it (e.g. Alembic
+ * array samples); in that case, owners keep that memory alive and must outlive
+ * any use of the buffers, including by Qt3D.
+ */
+struct PointCloudData
+{
+    /// Number of points
+    int npoints = 0;
+    /// Number of points in the archive, before decimation
+    int sourcePointCount = 0;
+    /// Layout of the vertex buffers
+    VertexFormat format = VertexFormat::Float;
+    /// Packed float32 XYZ positions (Float format)
+    QByteArray positions;
+    /// Packed float32 RGB colors (Float format)
+    QByteArray colors;
+    /// Interleaved positions and colors (Compact and Quantized formats)
+    QByteArray vertices;
+    /// Float32 radius of each point, derived from the spacing of its neighbours (optional)
+    QByteArray radii;
+    /// Quantized positions decoding: position = normalized * quantizationScale + quantizationOffset
+    float quantizationOffset[3] = {0.0f, 0.0f, 0.0f};
+    float quantizationScale[3] = {1.0f, 1.0f, 1.0f};
+    /// Bounds of the whole point cloud (also for chunks), in object space
+    BoundingBox bounds;
+    /// Owners of the memory referenced by raw buffers
+    std::vector<DataOwner> owners;
+    /// Level-of-detail octree, points being sorted by octree node (optional)
+    std::shared_ptr<const PointOctree> octree;
+    /// K-d tree over the points of the whole point cloud (also for chunks), for picking (optional)
+    std::shared_ptr<const PointKdTree> pickingTree;
+
+    /// Memory referenced by the vertex buffers and the picking tree, in bytes
+    std::size_t byteSize() const
+    {
+        return static_cast<std::size_t>(positions.size() + colors.size() + vertices.size() + radii.size()) +
+               (pickingTree ? pickingTree->byteSize() : 0);
+    }
+
+    /// Reference count points starting at first, without copying them
+    PointCloudData mid(int first, int count) const
+    {
+        const int stride = vertexStride(format);
+        PointCloudData chunk = *this;
+        chunk.npoints = count;
+        chunk.octree.reset();
+        if(format == VertexFormat::Float)
+        {
+            chunk.positions = QByteArray::fromRawData(positions.constData() + first * stride, count * stride);
+            chunk.colors = QByteArray::fromRawData(colors.constData() + first * stride, count * stride);
+            chunk.owners.push_back(makeDataOwner(positions));
+            chunk.owners.push_back(makeDataOwner(colors));
+        }
+        else
+        {
+            chunk.vertices = QByteArray::fromRawData(vertices.constData() + first * stride, count * stride);
+            chunk.owners.push_back(makeDataOwner(vertices));
+        }
+        if(!radii.isEmpty())
+        {
+            const int radiusSize = static_cast<int>(sizeof(float));
+            chunk.radii = QByteArray::fromRawData(radii.constData() + first * radiusSize, count * radiusSize);
+            chunk.owners.push_back(makeDataOwner(radii));
+        }
+        return chunk;
+    }
+};
+
+/**
+ * @brief Triangulated polygon mesh, ready to be uploaded to Qt3D buffers.
+ *
+ * Vertex attributes are stored in separate buffers, optional ones being empty when
+ * missing from the archive. Like PointCloudData, buffers may reference memory they
+ * do not own, kept alive by owners.
+ */
+struct MeshData
+{
+    /// Number of vertices, after splitting those with several normals, texture coordinates or colors
+    int vertexCount = 0;
+    /// Number of indices, 3 per triangle
+    int indexCount = 0;
+    /// Whether indices are 32-bit (16-bit otherwise)
+    bool largeIndices = false;
+    /// Packed float32 XYZ positions
+    QByteArray positions;
+    /// Packed float32 XYZ normals (optional)
+    QByteArray normals;
+    /// Packed float32 UV texture coordinates (optional)
+    QByteArray texCoords;
+    /// Packed float32 RGB colors (optional)
+    QByteArray colors;
+    /// Counter-clockwise triangles
+    QByteArray indices;
+    /// Bounds of the vertices, in object space
+    BoundingBox bounds;
+    /// Owners of the memory referenced by raw buffers
+    std::vector<DataOwner> owners;
+
+    /// Memory referenced by the buffers, in bytes
+    std::size_t byteSize() const
+    {
+        return static_cast<std::size_t>(positions.size() + normals.size() + texCoords.size() + colors.size() +
+                                        indices.size());
+    }
+};
+
+/**
+ * @brief Part of a streamed point cloud, uploaded as a separate buffer.
+ */
+struct PointCloudChunk
+{
+    /// Index of the streamed point cloud (see SceneNode::streamIndex)
+    int streamIndex = -1;
+    PointCloudData data;
+};
+
+/// Transform of an archive object, available even when the hierarchy is flattened
+struct ObjectTransform
+{
+    /// Full path of the parent object, empty for the root
+    QString parentPath;
+    /// Local transform
+    QMatrix4x4 matrix;
+    /// Transform relative to the archive root
+    QMatrix4x4 worldMatrix;
+};
+
+/// Transforms of archive objects, indexed by full path
+using TransformTable = QHash<QString, ObjectTransform>;
+
+/**
+ * @brief Plain C++ description of an Alembic object and its children.
+ *
+ * Built on the IO thread, it holds everything needed to instantiate the
+ * corresponding Qt3D entities without accessing the Alembic archive
+ * (except for properties, which are read lazily).
+ */
+struct SceneNode
+{
+    enum class Type
+    {
+        Unknown = 0,
+        Xform,
+        Points,
+        Camera,
+        Mesh
+    };
+
+    Type type = Type::Unknown;
+    QString name;
+    /// Full path in the archive
+    QString path;
+    /// Local transform (identity for non-Xform objects, world transform in a flattened hierarchy)
+    QMatrix4x4 matrix;
+    /// Transform relative to the archive root
+    QMatrix4x4 worldMatrix;
+    /// Vertex data (Points only, empty when streamed)
+    PointCloudData pointCloud;
+    /// Total number of points once loaded, after decimation (Points only)
+    int pointCount = 0;
+    /// Number of points in the archive (Points only)
+    int sourcePointCount = 0;
+    /// Index of the point cloud in the streaming order, -1 if not streamed
+    int streamIndex = -1;
+    /// Digest of the point cloud sample, computed from the keys of its arrays without reading them
+    /// (Points only, empty unless LoadOptions::watch is set)
+    QByteArray digest;
+    /// Whether the point cloud is known from LoadOptions::previousDigests: its vertex data is not read
+    bool unchanged = false;
+    /// Triangulated mesh (Mesh only)
+    MeshData mesh;
+    /// Properties, read on first access from the instantiated entity
+    PropertyMap arbProperties;
+    PropertyMap userProperties;
+    std::vector<std::unique_ptr<SceneNode>> children;
+    /// Transforms of all the objects read (root only)
+    TransformTable transforms;
+    /// Time-varying objects, null if the scene is static (root only)
+    std::shared_ptr<SceneAnimation> animation;
+};
+
+} // namespace
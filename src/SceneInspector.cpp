@@ -0,0 +1,151 @@
+#include "SceneInspector.hpp"
+#include <algorithm>
+
+using namespace Alembic::Abc;
+using namespace Alembic::AbcGeom;
+
+namespace abcentity
+{
+
+namespace
+{
+
+/// Number of elements of an array property sample, read from its dimensions only
+template<typename ArrayProperty>
+int readElementCount(ArrayProperty property, const ISampleSelector& iss)
+{
+    if(!property.valid() || property.getNumSamples() == 0)
+        return 0;
+    Dimensions dims;
+    property.getDimensions(dims, iss);
+    return static_cast<int>(dims.numPoints());
+}
+
+/// Self bounds stored in a geometry schema, empty if not stored
+template<typename Schema>
+BoundingBox readBounds(Schema& schema, const ISampleSelector& iss)
+{
+    IBox3dProperty selfBounds = schema.getSelfBoundsProperty();
+    if(!selfBounds.valid() || selfBounds.getNumSamples() == 0)
+        return BoundingBox();
+    const Box3d box = selfBounds.getValue(iss);
+    if(box.isEmpty())
+        return BoundingBox();
+    return BoundingBox(QVector3D(box.min.x, box.min.y, box.min.z), QVector3D(box.max.x, box.max.y, box.max.z));
+}
+
+template<typename Schema>
+void readProperties(Schema& schema, ObjectInfo& info)
+{
+    info.sampleCount = static_cast<int>(schema.getNumSamples());
+    info.arbProperties = PropertyMap(schema.getArbGeomParams());
+    info.userProperties = PropertyMap(schema.getUserProperties());
+}
+
+} // namespace
+
+SceneInspector::SceneInspector(const LoadOptions& options)
+    : _options(options)
+{
+}
+
+QString SceneInspector::typeName(SceneNode::Type type)
+{
+    switch(type)
+    {
+    case SceneNode::Type::Xform:
+        return QStringLiteral("Xform");
+    case SceneNode::Type::Points:
+        return QStringLiteral("Points");
+    case SceneNode::Type::Camera:
+        return QStringLiteral("Camera");
+    case SceneNode::Type::Mesh:
+        return QStringLiteral("Mesh");
+    case SceneNode::Type::Unknown:
+    default:
+        return QStringLiteral("Unknown");
+    }
+}
+
+void SceneInspector::inspect(const IObject& iObj, const Callback& callback, std::size_t batchSize)
+{
+    _callback = callback;
+    _batchSize = std::max<std::size_t>(batchSize, 1);
+    _count = 0;
+    _batch.clear();
+    inspectNode(iObj, -1, 0);
+    if(!_batch.empty())
+        _callback(std::move(_batch));
+    _batch.clear();
+}
+
+void SceneInspector::inspectNode(const IObject& iObj, int parent, int depth)
+{
+    if(_options.cancelled && _options.cancelled->load())
+        throw LoadCancelled();
+
+    ObjectInfo info;
+    info.name = QString::fromStdString(iObj.getName());
+    info.path = QString::fromStdString(iObj.getFullName());
+    info.parent = parent;
+    info.depth = depth;
+    info.childCount = static_cast<int>(iObj.getNumChildren());
+    try
+    {
+        readSchema(iObj, info);
+    }
+    catch(const std::exception&)
+    {
+        // invalid schema: only report the object header
+    }
+    const int index = _count++;
+    _batch.push_back(std::move(info));
+    if(_batch.size() >= _batchSize)
+    {
+        _callback(std::move(_batch));
+        _batch.clear();
+    }
+
+    for(std::size_t i = 0; i < iObj.getNumChildren(); ++i)
+        inspectNode(iObj.getChild(i), index, depth + 1);
+}
+
+void SceneInspector::readSchema(const IObject& iObj, ObjectInfo& info) const
+{
+    const MetaData& md = iObj.getMetaData();
+    info.schema = QString::fromStdString(md.get("schema"));
+    const ISampleSelector iss(_options.time);
+    if(IPoints::matches(md))
+    {
+        IPoints points(iObj, kWrapExisting);
+        IPointsSchema& schema = points.getSchema();
+        info.type = SceneNode::Type::Points;
+        readProperties(schema, info);
+        info.pointCount = readElementCount(schema.getPositionsProperty(), iss);
+        info.bounds = readBounds(schema, iss);
+    }
+    else if(IPolyMesh::matches(md))
+    {
+        IPolyMesh mesh(iObj, kWrapExisting);
+        IPolyMeshSchema& schema = mesh.getSchema();
+        info.type = SceneNode::Type::Mesh;
+        readProperties(schema, info);
+        info.pointCount = readElementCount(schema.getPositionsProperty(), iss);
+        info.faceCount = readElementCount(schema.getFaceCountsProperty(), iss);
+        info.bounds = readBounds(schema, iss);
+    }
+    else if(IXform::matches(md))
+    {
+        IXform xform(iObj, kWrapExisting);
+        info.type = SceneNode::Type::Xform;
+        readProperties(xform.getSchema(), info);
+    }
+    else if(ICamera::matches(md))
+    {
+        ICamera camera(iObj, kWrapExisting);
+        info.type = SceneNode::Type::Camera;
+        readProperties(camera.getSchema(), info);
+    }
+}
+
+} // namespace
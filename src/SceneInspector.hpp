@@ -0,0 +1,79 @@
+#pragma once
+
+#include "SceneReader.hpp"
+#include <Alembic/AbcGeom/All.h>
+#include <QStringList>
+#include <functional>
+#include <vector>
+
+namespace abcentity
+{
+
+/// Metadata of an archive object, read without its array payloads
+struct ObjectInfo
+{
+    SceneNode::Type type = SceneNode::Type::Unknown;
+    QString name;
+    /// Full path in the archive
+    QString path;
+    /// Schema of the object (e.g. "AbcGeom_Points_v1"), empty for plain objects
+    QString schema;
+    /// Index of the parent in the inspection order, -1 for the root
+    int parent = -1;
+    int depth = 0;
+    int childCount = 0;
+    /// Number of samples of the schema, 0 for plain objects
+    int sampleCount = 0;
+    /// Number of points (Points) or vertices (Mesh) at the inspected time
+    int pointCount = 0;
+    /// Number of faces (Mesh only)
+    int faceCount = 0;
+    /// Bounds stored in the archive at the inspected time (Points and Mesh only, empty if not stored)
+    BoundingBox bounds;
+    /// Arbitrary geometry parameters and user properties, values being read on first access
+    PropertyMap arbProperties;
+    PropertyMap userProperties;
+};
+
+/**
+ * @brief Walk the hierarchy of an archive, only reading object and property headers,
+ * array dimensions and stored bounds.
+ *
+ * Unlike SceneReader, no vertex data is read: inspecting a large archive costs about
+ * as much as reading its hierarchy. Does not create any QObject and can safely be used
+ * from a worker thread.
+ */
+class SceneInspector
+{
+public:
+    /// Receives the objects inspected since the previous call
+    using Callback = std::function<void(std::vector<ObjectInfo>&& objects)>;
+
+    /// Only LoadOptions::time and LoadOptions::cancelled are used
+    explicit SceneInspector(const LoadOptions& options);
+
+    /**
+     * @brief Inspect iObj and its descendants, depth first, parents coming before their children.
+     * @param callback called with batches of batchSize objects, and with the remaining ones at the end
+     * @throw LoadCancelled if the inspection has been cancelled
+     */
+    void inspect(const Alembic::Abc::IObject& iObj, const Callback& callback, std::size_t batchSize = 1024);
+
+    /// Name of an object type, as used by AlembicInspector
+    static QString typeName(SceneNode::Type type);
+
+private:
+    void inspectNode(const Alembic::Abc::IObject& iObj, int parent, int depth);
+    /// Read the schema metadata of an object
+    void readSchema(const Alembic::Abc::IObject& iObj, ObjectInfo& info) const;
+
+private:
+    LoadOptions _options;
+    Callback _callback;
+    std::size_t _batchSize = 1024;
+    /// Number of objects inspected so far
+    int _count = 0;
+    std::vector<ObjectInfo> _batch;
+};
+
+} // namespace
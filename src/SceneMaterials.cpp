@@ -0,0 +1,242 @@
+#include "SceneMaterials.hpp"
+#include <Qt3DRender/QTechnique>
+#include <Qt3DRender/QRenderPass>
+#include <Qt3DRender/QShaderProgram>
+#include <Qt3DExtras/QPerVertexColorMaterial>
+#include <QVector3D>
+
+namespace abcentity
+{
+
+SceneMaterials::SceneMaterials(Qt3DCore::QNode* parent)
+    : Qt3DCore::QNode(parent)
+    , _pointSizeParameter(new Qt3DRender::QParameter(QStringLiteral("pointSize"), _pointSize, this))
+{
+    using namespace Qt3DRender;
+    using namespace Qt3DExtras;
+
+    _cloudMaterial = new QMaterial(this);
+    _cameraMaterial = new QPerVertexColorMaterial(this);
+    _meshMaterial = new QMaterial(this);
+
+    // configure cloud materials: one effect whose shader program depends on the point style
+    _cloudEffect = new QEffect(this);
+    _cloudRenderPass = new QRenderPass;
+
+    // both programs are kept alive by this node while one of them is used
+    auto shaderProgram = new QShaderProgram(this);
+    shaderProgram->setVertexShaderCode(R"(#version 130
+    in vec3 vertexPosition;
+    in vec3 vertexColor;
+    in float vertexRadius;
+    out vec3 color;
+    uniform mat4 mvp;
+    uniform mat4 projectionMatrix;
+    uniform mat4 viewportMatrix;
+    uniform float pointSize;
+    uniform vec3 positionOffset;
+    uniform vec3 positionScale;
+    void main()
+    {
+        color = vertexColor;
+        // decode quantized positions (identity for float positions)
+        vec3 position = vertexPosition * positionScale + positionOffset;
+        gl_Position = mvp * vec4(position, 1.0);
+        // adaptive size from the point radius, if any
+        float size = max(pointSize, 2.0 * vertexRadius);
+        gl_PointSize = max(viewportMatrix[1][1] * projectionMatrix[1][1] * size / gl_Position.w, 1.0);
+    }
+    )");
+
+    // set fragment shader
+    shaderProgram->setFragmentShaderCode(R"(#version 130
+        in vec3 color;
+        out vec4 fragColor;
+        void main(void)
+        {
+            fragColor = vec4(color, 1.0);
+        }
+    )");
+
+    auto splatShaderProgram = new QShaderProgram(this);
+    splatShaderProgram->setVertexShaderCode(R"(#version 130
+    in vec3 vertexPosition;
+    in vec3 vertexColor;
+    in float vertexRadius;
+    out vec3 color;
+    out vec3 viewCenter;
+    out float viewRadius;
+    uniform mat4 modelView;
+    uniform mat4 mvp;
+    uniform mat4 projectionMatrix;
+    uniform mat4 viewportMatrix;
+    uniform float pointSize;
+    uniform vec3 positionOffset;
+    uniform vec3 positionScale;
+    void main()
+    {
+        color = vertexColor;
+        vec3 position = vertexPosition * positionScale + positionOffset;
+        float size = max(pointSize, 2.0 * vertexRadius);
+        viewCenter = (modelView * vec4(position, 1.0)).xyz;
+        viewRadius = 0.5 * size;
+        gl_Position = mvp * vec4(position, 1.0);
+        gl_PointSize = max(viewportMatrix[1][1] * projectionMatrix[1][1] * size / gl_Position.w, 1.0);
+    }
+    )");
+
+    splatShaderProgram->setFragmentShaderCode(R"(#version 130
+        in vec3 color;
+        in vec3 viewCenter;
+        in float viewRadius;
+        out vec4 fragColor;
+        uniform mat4 projectionMatrix;
+        void main(void)
+        {
+            // round splats: discard the corners of the point sprite
+            vec2 coord = gl_PointCoord * 2.0 - 1.0;
+            float r2 = dot(coord, coord);
+            if(r2 > 1.0)
+                discard;
+            // depth of the sphere in front of the fragment, for overlapping splats to blend into a surface
+            vec4 clip = projectionMatrix * vec4(viewCenter + vec3(0.0, 0.0, viewRadius * sqrt(1.0 - r2)), 1.0);
+            gl_FragDepth = 0.5 * (gl_DepthRange.diff * clip.z / clip.w + gl_DepthRange.near + gl_DepthRange.far);
+            // darken the rims to show the shape of splats
+            fragColor = vec4(color * (1.0 - 0.25 * r2), 1.0);
+        }
+    )");
+
+    _squareShaderProgram = shaderProgram;
+    _splatShaderProgram = splatShaderProgram;
+
+    // add a pointSize uniform, on the effect to be shared by all cloud materials
+    _cloudEffect->addParameter(_pointSizeParameter);
+
+    // default position decoding, overridden by materials of quantized point clouds
+    _cloudEffect->addParameter(new QParameter(QStringLiteral("positionOffset"), QVector3D(0.0f, 0.0f, 0.0f)));
+    _cloudEffect->addParameter(new QParameter(QStringLiteral("positionScale"), QVector3D(1.0f, 1.0f, 1.0f)));
+
+    auto technique = new QTechnique;
+    _cloudRenderPass->setShaderProgram(_squareShaderProgram);
+    technique->addRenderPass(_cloudRenderPass);
+    _cloudEffect->addTechnique(technique);
+
+    // build the material
+    _cloudMaterial->setEffect(_cloudEffect);
+
+    // configure mesh material: headlight shading, flat without normals
+    auto meshEffect = new QEffect;
+    auto meshTechnique = new QTechnique;
+    auto meshRenderPass = new QRenderPass;
+    auto meshShaderProgram = new QShaderProgram;
+
+    meshShaderProgram->setVertexShaderCode(R"(#version 130
+    in vec3 vertexPosition;
+    in vec3 vertexNormal;
+    in vec3 vertexColor;
+    out vec3 position;
+    out vec3 normal;
+    out vec3 color;
+    uniform mat4 modelView;
+    uniform mat3 modelViewNormal;
+    uniform mat4 mvp;
+    uniform bool hasColors;
+    uniform vec3 defaultColor;
+    void main()
+    {
+        position = (modelView * vec4(vertexPosition, 1.0)).xyz;
+        normal = modelViewNormal * vertexNormal;
+        color = hasColors ? vertexColor : defaultColor;
+        gl_Position = mvp * vec4(vertexPosition, 1.0);
+    }
+    )");
+
+    meshShaderProgram->setFragmentShaderCode(R"(#version 130
+        in vec3 position;
+        in vec3 normal;
+        in vec3 color;
+        out vec4 fragColor;
+        uniform bool hasNormals;
+        void main(void)
+        {
+            // face normal from the screen-space derivatives of the view-space position
+            vec3 n = hasNormals ? normalize(normal) : normalize(cross(dFdx(position), dFdy(position)));
+            // two-sided lighting from the camera
+            float diffuse = abs(dot(n, normalize(-position)));
+            fragColor = vec4(color * (0.2 + 0.8 * diffuse), 1.0);
+        }
+    )");
+
+    // defaults for meshes without optional attributes, overridden by their own materials otherwise
+    meshEffect->addParameter(new QParameter(QStringLiteral("hasNormals"), false));
+    meshEffect->addParameter(new QParameter(QStringLiteral("hasColors"), false));
+    meshEffect->addParameter(new QParameter(QStringLiteral("defaultColor"), QVector3D(0.8f, 0.8f, 0.8f)));
+
+    meshRenderPass->setShaderProgram(meshShaderProgram);
+    meshTechnique->addRenderPass(meshRenderPass);
+    meshEffect->addTechnique(meshTechnique);
+    _meshMaterial->setEffect(meshEffect);
+
+    // configure camera batch effect: locators drawn once per instance transform
+    _cameraBatchEffect = new QEffect(this);
+    auto cameraBatchTechnique = new QTechnique;
+    auto cameraBatchRenderPass = new QRenderPass;
+    auto cameraBatchShaderProgram = new QShaderProgram;
+
+    cameraBatchShaderProgram->setVertexShaderCode(R"(#version 130
+    in vec3 vertexPosition;
+    in vec3 vertexColor;
+    in vec4 instanceModel0;
+    in vec4 instanceModel1;
+    in vec4 instanceModel2;
+    in vec4 instanceModel3;
+    out vec3 color;
+    uniform mat4 mvp;
+    uniform float locatorScale;
+    void main()
+    {
+        color = vertexColor;
+        mat4 instanceModel = mat4(instanceModel0, instanceModel1, instanceModel2, instanceModel3);
+        gl_Position = mvp * instanceModel * vec4(vertexPosition * locatorScale, 1.0);
+    }
+    )");
+
+    cameraBatchShaderProgram->setFragmentShaderCode(R"(#version 130
+        in vec3 color;
+        out vec4 fragColor;
+        void main(void)
+        {
+            fragColor = vec4(color, 1.0);
+        }
+    )");
+
+    // default scale, overridden by the material of each batch
+    _cameraBatchEffect->addParameter(new QParameter(QStringLiteral("locatorScale"), 1.0f));
+
+    cameraBatchRenderPass->setShaderProgram(cameraBatchShaderProgram);
+    cameraBatchTechnique->addRenderPass(cameraBatchRenderPass);
+    _cameraBatchEffect->addTechnique(cameraBatchTechnique);
+}
+
+void SceneMaterials::setPointSize(float value)
+{
+    if(_pointSize == value)
+        return;
+    _pointSize = value;
+    _pointSizeParameter->setValue(value);
+    // materials of quantized point clouds follow the entities using these materials
+    _cloudMaterial->setEnabled(_pointSize > 0.0f);
+    Q_EMIT pointSizeChanged();
+}
+
+void SceneMaterials::setPointStyle(PointStyle value)
+{
+    if(_pointStyle == value)
+        return;
+    _pointStyle = value;
+    // all materials sharing the cloud effect are updated at once
+    _cloudRenderPass->setShaderProgram(_pointStyle == PointStyle::Splat ? _splatShaderProgram : _squareShaderProgram);
+    Q_EMIT pointStyleChanged();
+}
+
+} // namespace
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Qt3DCore/QNode>
+#include <Qt3DRender/QEffect>
+#include <Qt3DRender/QMaterial>
+#include <Qt3DRender/QParameter>
+#include <Qt3DRender/QRenderPass>
+#include <Qt3DRender/QShaderProgram>
+
+namespace abcentity
+{
+
+/// Shape of rendered points
+enum class PointStyle
+{
+    /// Flat square points
+    Square = 0,
+    /// Round splats, depth-corrected as spheres
+    Splat
+};
+
+/**
+ * @brief Materials, effects and shader programs used to render the objects of archives.
+ *
+ * Each AlembicEntity creates its own, unless it is given the materials of an
+ * AlembicSceneGroup shared by all its archives. Materials are components that
+ * can be added to any number of entities. The point size and style apply to all
+ * the entities using these materials.
+ */
+class SceneMaterials : public Qt3DCore::QNode
+{
+    Q_OBJECT
+
+public:
+    explicit SceneMaterials(Qt3DCore::QNode* parent = nullptr);
+
+    /// Material of point clouds; quantized point clouds use their own material sharing its effect
+    Qt3DRender::QMaterial* cloudMaterial() const { return _cloudMaterial; }
+    Qt3DRender::QMaterial* cameraMaterial() const { return _cameraMaterial; }
+    Qt3DRender::QMaterial* meshMaterial() const { return _meshMaterial; }
+    /// Effect of all point cloud materials
+    Qt3DRender::QEffect* cloudEffect() const { return _cloudEffect; }
+    /// Effect of instanced camera locators, scaled by the locatorScale parameter of their material
+    Qt3DRender::QEffect* cameraBatchEffect() const { return _cameraBatchEffect; }
+
+    float pointSize() const { return _pointSize; }
+    /// Set the size of points; point cloud materials are disabled if <= 0
+    void setPointSize(float value);
+    PointStyle pointStyle() const { return _pointStyle; }
+    /// Set the shader program of the cloud effect
+    void setPointStyle(PointStyle value);
+
+public:
+    Q_SIGNAL void pointSizeChanged();
+    Q_SIGNAL void pointStyleChanged();
+
+private:
+    float _pointSize = 0.5f;
+    PointStyle _pointStyle = PointStyle::Square;
+    Qt3DRender::QParameter* _pointSizeParameter;
+    Qt3DRender::QMaterial* _cloudMaterial;
+    Qt3DRender::QEffect* _cloudEffect;
+    Qt3DRender::QRenderPass* _cloudRenderPass;
+    Qt3DRender::QShaderProgram* _squareShaderProgram;
+    Qt3DRender::QShaderProgram* _splatShaderProgram;
+    Qt3DRender::QMaterial* _cameraMaterial;
+    Qt3DRender::QEffect* _cameraBatchEffect;
+    Qt3DRender::QMaterial* _meshMaterial;
+};
+
+} // namespace
@@ -0,0 +1,844 @@
+#include "SceneReader.hpp"
+#include "ArchiveCache.hpp"
+#include "SceneAnimation.hpp"
+#include "AlembicProperties.hpp"
+#include "ConversionKernels.hpp"
+#include "MeshTriangulation.hpp"
+#include "ParallelFor.hpp"
+#include "PointSpacing.hpp"
+#include <QCryptographicHash>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Alembic::Abc;
+using namespace Alembic::AbcGeom;
+
+namespace abcentity
+{
+
+namespace
+{
+
+inline quint16 toUnsignedShort(float value)
+{
+    return static_cast<quint16>(value > 0.0f ? (value < 1.0f ? value * 65535.0f + 0.5f : 65535.0f) : 0.0f);
+}
+
+/**
+ * @brief Read an rgb array property as packed float32 RGB colors.
+ * Float32 colors are referenced without copy, their sample being added to owners.
+ * The size of the sample is added to bytesRead.
+ * @return the colors, or an empty array if the property does not hold one color per point
+ */
+QByteArray readColors(const IArrayProperty& prop, const ISampleSelector& iss, int npoints, std::vector<DataOwner>& owners,
+                      qint64& bytesRead)
+{
+    Alembic::AbcCoreAbstract::ArraySamplePtr samp;
+    prop.get(samp, iss);
+    const Alembic::AbcCoreAbstract::DataType& dtype = prop.getDataType();
+    bytesRead += static_cast<qint64>(samp->size() * dtype.getNumBytes());
+    const std::size_t nvalues = static_cast<std::size_t>(npoints) * 3;
+    if(samp->size() * dtype.getExtent() != nvalues)
+        return QByteArray();
+
+    const int size = static_cast<int>(nvalues * sizeof(float));
+    QByteArray colors;
+    switch(dtype.getPod())
+    {
+    case kFloat32POD:
+        owners.push_back(makeDataOwner(samp));
+        return QByteArray::fromRawData(static_cast<const char*>(samp->getData()), size);
+    case kFloat16POD:
+        colors = QByteArray(size, Qt::Uninitialized);
+        kernels::halfToFloat(static_cast<const uint16_t*>(samp->getData()), reinterpret_cast<float*>(colors.data()), nvalues);
+        return colors;
+    case kUint8POD:
+        colors = QByteArray(size, Qt::Uninitialized);
+        kernels::unorm8ToFloat(static_cast<const uint8_t*>(samp->getData()), reinterpret_cast<float*>(colors.data()), nvalues);
+        return colors;
+    case kFloat64POD:
+    {
+        colors = QByteArray(size, Qt::Uninitialized);
+        const double* src = static_cast<const double*>(samp->getData());
+        std::transform(src, src + nvalues, reinterpret_cast<float*>(colors.data()),
+                       [](double value) { return static_cast<float>(value); });
+        return colors;
+    }
+    default:
+        return QByteArray();
+    }
+}
+
+/// Digest of the vertex data of a point cloud sample, from the keys of its positions and colors (empty if unavailable)
+QByteArray pointsDigest(const IPoints& points, const ISampleSelector& iss)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    Alembic::AbcCoreAbstract::ArraySampleKey key;
+    const auto addKey = [&hash, &key]() {
+        const std::string digest = key.digest.str();
+        hash.addData(digest.data(), static_cast<int>(digest.size()));
+    };
+
+    IPointsSchema schema = points.getSchema();
+    IP3fArrayProperty positions = schema.getPositionsProperty();
+    if(!positions.valid() || positions.getNumSamples() == 0 || !positions.getKey(key, iss))
+        return QByteArray();
+    addKey();
+
+    // colors are read from the first valid rgb property: include all of them
+    ICompoundProperty cProp = schema.getArbGeomParams();
+    if(cProp)
+    {
+        for(std::size_t i = 0; i < cProp.getNumProperties(); ++i)
+        {
+            const PropertyHeader& propHeader = cProp.getPropertyHeader(i);
+            if(!propHeader.isArray() || propHeader.getMetaData().get("interpretation") != "rgb")
+                continue;
+            IArrayProperty prop(cProp, propHeader.getName());
+            if(prop.getNumSamples() > 0 && prop.getKey(key, iss))
+                addKey();
+        }
+    }
+    return hash.result();
+}
+
+/**
+ * @brief Read a geometry parameter of a mesh as a triangulation attribute, keeping its indices if indexed.
+ * The scope is guessed from the size of the parameter if unknown; constant and uniform parameters are ignored.
+ * The sample must outlive the attribute.
+ */
+template<typename Param>
+void readMeshAttribute(const Param& param, const ISampleSelector& iss, int components, PolygonMesh& mesh,
+                       typename Param::Sample& sample, PolygonMesh::Attribute& attribute, qint64& bytesRead)
+{
+    if(!param.valid() || param.getNumSamples() == 0)
+        return;
+    if(param.isIndexed())
+        param.getIndexed(sample, iss);
+    else
+        param.getExpanded(sample, iss);
+    const auto& values = sample.getVals();
+    if(!values || values->size() == 0)
+        return;
+    const UInt32ArraySamplePtr& indices = sample.getIndices();
+    const std::size_t size = indices ? indices->size() : values->size();
+    switch(sample.getScope())
+    {
+    case kFacevaryingScope:
+        attribute.perCorner = true;
+        break;
+    case kVertexScope:
+    case kVaryingScope:
+        attribute.perCorner = false;
+        break;
+    case kConstantScope:
+    case kUniformScope:
+        return;
+    default:
+        attribute.perCorner = size == mesh.cornerCount && size != mesh.vertexCount;
+        break;
+    }
+    attribute.values = reinterpret_cast<const float*>(values->get());
+    attribute.count = values->size();
+    attribute.components = components;
+    bytesRead += static_cast<qint64>(values->size() * components * sizeof(float));
+    if(indices)
+    {
+        attribute.indices = indices->get();
+        attribute.indexCount = indices->size();
+        bytesRead += static_cast<qint64>(indices->size() * sizeof(uint32_t));
+    }
+}
+
+QMatrix4x4 toQMatrix(const M44d& mat)
+{
+    return QMatrix4x4(mat[0][0], mat[1][0], mat[2][0], mat[3][0], mat[0][1], mat[1][1], mat[2][1],
+                      mat[3][1], mat[0][2], mat[1][2], mat[2][2], mat[3][2], mat[0][3], mat[1][3],
+                      mat[2][3], mat[3][3]);
+}
+
+} // namespace
+
+SceneReader::SceneReader(const LoadOptions& options)
+    : _options(options)
+{
+}
+
+bool SceneReader::isHidden(const IObject& iObj) const
+{
+    if(!_options.skipHidden)
+        return false;
+
+    // Skip objects with visibilityProperty explicitly set to hidden
+    const auto& prop = iObj.getProperties();
+    if(!prop.getPropertyHeader(kVisibilityPropertyName))
+        return false;
+
+    IVisibilityProperty visibilityProperty(prop, kVisibilityPropertyName);
+    return ObjectVisibility(visibilityProperty.getValue()) == kVisibilityHidden;
+}
+
+std::unique_ptr<SceneNode> SceneReader::read(const IObject& iObj)
+{
+    _transforms.clear();
+    _animation = std::make_shared<SceneAnimation>(_options);
+    _xformStack.clear();
+    _animatedXformCount = 0;
+    _pendingPoints.clear();
+    _pendingMeshes.clear();
+    _undecodedNodes.clear();
+    LoadStatistics* statistics = _options.statistics.get();
+    std::unique_ptr<SceneNode> root;
+    {
+        LoadStatistics::Scope scope(statistics, "walk");
+        root = readNode(iObj, nullptr);
+    }
+    if(!root)
+        return nullptr;
+    applyPointBudget();
+    {
+        LoadStatistics::Scope scope(statistics, "decode");
+        readPendingPoints();
+        readPendingMeshes();
+    }
+    if(_options.flattenHierarchy)
+    {
+        std::unique_ptr<SceneNode> flatRoot(new SceneNode);
+        flatRoot->name = root->name;
+        flatRoot->path = root->path;
+        flatRoot->arbProperties = root->arbProperties;
+        flatRoot->userProperties = root->userProperties;
+        for(auto& child : root->children)
+            flatten(std::move(child), *flatRoot);
+        root = std::move(flatRoot);
+    }
+    root->transforms.swap(_transforms);
+    if(!_animation->isEmpty())
+        root->animation = _animation;
+    _animation.reset();
+    return root;
+}
+
+void SceneReader::readPendingPoints()
+{
+    parallelFor(static_cast<int>(_pendingPoints.size()), _options.threadCount, [this](int i) {
+        SceneNode* node = _pendingPoints[i].first;
+        node->pointCloud = readPointCloud(_pendingPoints[i].second);
+        node->pointCount = node->pointCloud.npoints;
+        node->sourcePointCount = node->pointCloud.sourcePointCount;
+    });
+    _pendingPoints.clear();
+}
+
+void SceneReader::readPendingMeshes()
+{
+    parallelFor(static_cast<int>(_pendingMeshes.size()), _options.threadCount, [this](int i) {
+        _pendingMeshes[i].first->mesh = readMesh(_pendingMeshes[i].second, _options.time);
+    });
+    _pendingMeshes.clear();
+}
+
+void SceneReader::applyPointBudget()
+{
+    _options.subsampleRatio = 1.0;
+    if(_options.maxPoints > 0)
+    {
+        // point counts are read from the sample dimensions, without decoding positions
+        qint64 totalPointCount = 0;
+        for(const auto& pending : _pendingPoints)
+            totalPointCount += readPointCount(pending.second, _options.time);
+        for(const SceneNode* node : _undecodedNodes)
+            totalPointCount += node->sourcePointCount;
+        if(totalPointCount > _options.maxPoints)
+            _options.subsampleRatio = static_cast<double>(_options.maxPoints) / static_cast<double>(totalPointCount);
+    }
+    for(SceneNode* node : _undecodedNodes)
+        node->pointCount = subsampledPointCount(node->sourcePointCount);
+    // animation samples are decimated with the same ratio
+    _animation->setLoadOptions(_options);
+}
+
+int SceneReader::subsampledPointCount(int npoints) const
+{
+    if(_options.subsampleRatio >= 1.0 || npoints <= 0)
+        return npoints;
+    return std::max(1, static_cast<int>(npoints * _options.subsampleRatio));
+}
+
+void SceneReader::flatten(std::unique_ptr<SceneNode> node, SceneNode& root)
+{
+    std::vector<std::unique_ptr<SceneNode>> children;
+    children.swap(node->children);
+    if(node->type == SceneNode::Type::Points || node->type == SceneNode::Type::Camera ||
+       node->type == SceneNode::Type::Mesh)
+    {
+        // bake the accumulated transform
+        node->matrix = node->worldMatrix;
+        root.children.push_back(std::move(node));
+    }
+    for(auto& child : children)
+        flatten(std::move(child), root);
+}
+
+std::unique_ptr<SceneNode> SceneReader::readNode(const IObject& iObj, const SceneNode* parent)
+{
+    checkCancelled();
+    if(isHidden(iObj))
+        return nullptr;
+    if(_options.statistics)
+        _options.statistics->add(LoadStatistics::Counter::Objects, 1);
+
+    std::unique_ptr<SceneNode> node(new SceneNode);
+    node->name = QString::fromStdString(iObj.getName());
+    node->path = QString::fromStdString(iObj.getFullName());
+
+    const MetaData& md = iObj.getMetaData();
+    if(IPoints::matches(md))
+    {
+        IPoints points(iObj, kWrapExisting);
+        node->type = SceneNode::Type::Points;
+        // digests are only compared by the reloads of watched archives
+        if(_options.watch)
+            node->digest = pointsDigest(points, ISampleSelector(_options.time));
+        node->unchanged = !node->digest.isEmpty() && _options.previousDigests.value(node->path) == node->digest;
+        if(_options.streaming || node->unchanged)
+        {
+            node->sourcePointCount = readPointCount(points, _options.time);
+            node->pointCount = node->sourcePointCount;
+            if(!node->unchanged)
+            {
+                node->streamIndex = static_cast<int>(_deferredPoints.size());
+                _deferredPoints.push_back(points);
+            }
+            _undecodedNodes.push_back(node.get());
+        }
+        else
+        {
+            // decoded in parallel once the hierarchy has been read
+            _pendingPoints.push_back(std::make_pair(node.get(), points));
+        }
+        node->arbProperties = PropertyMap(points.getSchema().getArbGeomParams());
+        node->userProperties = PropertyMap(points.getSchema().getUserProperties());
+    }
+    else if(IPolyMesh::matches(md))
+    {
+        IPolyMesh mesh(iObj, kWrapExisting);
+        node->type = SceneNode::Type::Mesh;
+        // decoded in parallel with point clouds
+        _pendingMeshes.push_back(std::make_pair(node.get(), mesh));
+        node->arbProperties = PropertyMap(mesh.getSchema().getArbGeomParams());
+        node->userProperties = PropertyMap(mesh.getSchema().getUserProperties());
+    }
+    else if(IXform::matches(md))
+    {
+        IXform xform(iObj, kWrapExisting);
+        node->type = SceneNode::Type::Xform;
+        node->matrix = readMatrix(xform, _options.time);
+        node->arbProperties = PropertyMap(xform.getSchema().getArbGeomParams());
+        node->userProperties = PropertyMap(xform.getSchema().getUserProperties());
+    }
+    else if(ICamera::matches(md))
+    {
+        ICamera cam(iObj, kWrapExisting);
+        node->type = SceneNode::Type::Camera;
+        node->arbProperties = PropertyMap(cam.getSchema().getArbGeomParams());
+        node->userProperties = PropertyMap(cam.getSchema().getUserProperties());
+    }
+    // else: fallback, keep an empty node to preserve hierarchy
+    node->worldMatrix = parent ? parent->worldMatrix * node->matrix : node->matrix;
+
+    ObjectTransform& transform = _transforms[node->path];
+    transform.parentPath = parent ? parent->path : QString();
+    transform.matrix = node->matrix;
+    transform.worldMatrix = node->worldMatrix;
+
+    addAnimationTracks(*node, iObj);
+
+    // visit children
+    const bool isXform = node->type == SceneNode::Type::Xform;
+    if(isXform)
+    {
+        IXform xform(iObj, kWrapExisting);
+        _xformStack.push_back(xform);
+        _animatedXformCount += xform.getSchema().isConstant() ? 0 : 1;
+    }
+    for(size_t i = 0; i < iObj.getNumChildren(); i++)
+    {
+        std::unique_ptr<SceneNode> child = readNode(iObj.getChild(i), node.get());
+        if(child)
+            node->children.push_back(std::move(child));
+    }
+    if(isXform)
+    {
+        _animatedXformCount -= _xformStack.back().getSchema().isConstant() ? 0 : 1;
+        _xformStack.pop_back();
+    }
+    return node;
+}
+
+void SceneReader::addAnimationTracks(const SceneNode& node, const IObject& iObj)
+{
+    using TransformTrack = SceneAnimation::TransformTrack;
+
+    if(node.type == SceneNode::Type::Xform)
+    {
+        IXform xform(iObj, kWrapExisting);
+        IXformSchema& schema = xform.getSchema();
+        if(!schema.isConstant())
+        {
+            _animation->addTimeSampling(schema.getTimeSampling(), schema.getNumSamples());
+            // flattened Xforms have no entity
+            if(!_options.flattenHierarchy)
+            {
+                TransformTrack track;
+                track.space = TransformTrack::Space::Local;
+                track.path = node.path;
+                track.xforms.push_back(xform);
+                _animation->addTransformTrack(track);
+            }
+        }
+    }
+    // same node types as those kept by flatten()
+    const bool isLeaf = node.type == SceneNode::Type::Points || node.type == SceneNode::Type::Camera ||
+                        node.type == SceneNode::Type::Mesh;
+    if(isLeaf && _animatedXformCount > 0)
+    {
+        // used by flattened hierarchies and batched cameras
+        TransformTrack track;
+        track.space = TransformTrack::Space::World;
+        track.path = node.path;
+        track.xforms = _xformStack;
+        _animation->addTransformTrack(track);
+    }
+    if(node.type == SceneNode::Type::Points)
+    {
+        IPoints points(iObj, kWrapExisting);
+        IPointsSchema& schema = points.getSchema();
+        if(!schema.isConstant())
+        {
+            SceneAnimation::PointsTrack track;
+            track.path = node.path;
+            track.points = points;
+            _animation->addPointsTrack(track);
+            _animation->addTimeSampling(schema.getTimeSampling(), schema.getNumSamples());
+        }
+    }
+}
+
+QMatrix4x4 SceneReader::readMatrix(const IXform& xform, double time)
+{
+    XformSample xs;
+    xform.getSchema().get(xs, ISampleSelector(time));
+    return toQMatrix(xs.getMatrix());
+}
+
+int SceneReader::readPointCount(const IPoints& points, double time)
+{
+    IP3fArrayProperty positions = points.getSchema().getPositionsProperty();
+    if(!positions.valid() || positions.getNumSamples() == 0)
+        return 0;
+    Dimensions dims;
+    positions.getDimensions(dims, ISampleSelector(time));
+    return static_cast<int>(dims.numPoints());
+}
+
+PointCloudData SceneReader::readPointCloud(const IPoints& points, double time) const
+{
+    checkCancelled();
+    LoadStatistics* statistics = _options.statistics.get();
+    LoadStatistics::Scope scope(statistics, "decodePointCloud");
+    PointCloudData data;
+    const ISampleSelector iss(time);
+    IPointsSchema schema = points.getSchema();
+
+    // reuse the point cloud if already decoded with the same options, e.g. by another view
+    QString cacheKey;
+    if(!_options.archiveKey.isEmpty())
+    {
+        const index_t sampleIndex = iss.getIndex(schema.getTimeSampling(), schema.getNumSamples());
+        cacheKey = ArchiveCache::pointCloudKey(_options.archiveKey, QString::fromStdString(points.getFullName()),
+                                               sampleIndex, subsampledPointCount(readPointCount(points, time)),
+                                               _options.levelOfDetail, _options.vertexFormat, _options.pointRadii,
+                                               _options.pickingTree);
+        std::shared_ptr<const PointCloudData> cached = ArchiveCache::instance().pointCloud(cacheKey);
+        if(cached)
+        {
+            if(statistics)
+                statistics->add(LoadStatistics::Counter::CachedPointClouds, 1);
+            return *cached;
+        }
+    }
+
+    // read position data
+    P3fArraySamplePtr positions = schema.getValue(iss).getPositions();
+    data.npoints = static_cast<int>(positions->size());
+    data.sourcePointCount = data.npoints;
+    qint64 bytesRead = static_cast<qint64>(positions->size() * sizeof(V3f));
+    // reference the sample memory without copying it
+    data.positions = QByteArray::fromRawData((const char*)positions->get(), data.npoints * 3 * static_cast<int>(sizeof(float)));
+    data.owners.push_back(makeDataOwner(positions));
+
+    // check if we have a color property
+    ICompoundProperty cProp = schema.getArbGeomParams();
+    if(cProp)
+    {
+        std::size_t numProps = cProp.getNumProperties();
+        for(std::size_t i = 0; i < numProps && data.colors.isEmpty(); ++i)
+        {
+            const PropertyHeader& propHeader = cProp.getPropertyHeader(i);
+            if(propHeader.isArray())
+            {
+                const std::string& propName = propHeader.getName();
+                Alembic::Abc::IArrayProperty prop(cProp, propName);
+                std::string interp = prop.getMetaData().get("interpretation");
+                if(interp == "rgb")
+                    data.colors = readColors(prop, iss, data.npoints, data.owners, bytesRead);
+            }
+        }
+    }
+
+    // if needed, fill the buffer with a default color
+    if(data.colors.isEmpty())
+    {
+        data.colors = QByteArray(data.npoints * 3 * static_cast<int>(sizeof(float)), Qt::Uninitialized);
+        kernels::fill(reinterpret_cast<float*>(data.colors.data()), static_cast<std::size_t>(data.npoints) * 3, 0.8f);
+    }
+
+    if(statistics)
+    {
+        statistics->add(LoadStatistics::Counter::PointClouds, 1);
+        statistics->add(LoadStatistics::Counter::PointsRead, data.npoints);
+        statistics->add(LoadStatistics::Counter::BytesRead, bytesRead);
+    }
+
+    // quantization requires the exact bounds of the points: only trust the stored ones otherwise
+    IBox3dProperty selfBounds = schema.getSelfBoundsProperty();
+    if(_options.vertexFormat != VertexFormat::Quantized && selfBounds.valid() && selfBounds.getNumSamples() > 0)
+    {
+        const Box3d box = selfBounds.getValue(iss);
+        if(!box.isEmpty())
+            data.bounds = BoundingBox(QVector3D(box.min.x, box.min.y, box.min.z), QVector3D(box.max.x, box.max.y, box.max.z));
+    }
+    if(data.bounds.isEmpty())
+    {
+        float minCorner[3], maxCorner[3];
+        kernels::bounds(reinterpret_cast<const float*>(data.positions.constData()), static_cast<std::size_t>(data.npoints),
+                        minCorner, maxCorner);
+        data.bounds = BoundingBox(QVector3D(minCorner[0], minCorner[1], minCorner[2]),
+                                  QVector3D(maxCorner[0], maxCorner[1], maxCorner[2]));
+    }
+
+    checkCancelled();
+    decimate(data, subsampledPointCount(data.npoints));
+    checkCancelled();
+    if(_options.levelOfDetail)
+        buildOctree(data);
+    checkCancelled();
+    // once points are decimated and sorted by octree node
+    if(_options.pointRadii)
+        computeRadii(data);
+    checkCancelled();
+    if(_options.pickingTree)
+        buildPickingTree(data);
+    checkCancelled();
+    encodeVertices(data, _options.vertexFormat);
+    if(!cacheKey.isEmpty())
+        ArchiveCache::instance().insertPointCloud(_options.archiveKey, cacheKey, data);
+    return data;
+}
+
+MeshData SceneReader::readMesh(const IPolyMesh& mesh, double time) const
+{
+    checkCancelled();
+    LoadStatistics* statistics = _options.statistics.get();
+    LoadStatistics::Scope scope(statistics, "decodeMesh");
+    const ISampleSelector iss(time);
+    IPolyMeshSchema schema = mesh.getSchema();
+    if(schema.getNumSamples() == 0)
+        return MeshData();
+
+    IPolyMeshSchema::Sample sample;
+    schema.get(sample, iss);
+    const P3fArraySamplePtr positions = sample.getPositions();
+    const Int32ArraySamplePtr faceCounts = sample.getFaceCounts();
+    const Int32ArraySamplePtr faceIndices = sample.getFaceIndices();
+    if(!positions || !faceCounts || !faceIndices)
+        return MeshData();
+    PolygonMesh polygons;
+    polygons.positions = reinterpret_cast<const float*>(positions->get());
+    polygons.vertexCount = positions->size();
+    polygons.faceCounts = faceCounts->get();
+    polygons.faceCount = faceCounts->size();
+    polygons.faceIndices = faceIndices->get();
+    polygons.cornerCount = faceIndices->size();
+    qint64 bytesRead = static_cast<qint64>(positions->size() * sizeof(V3f) +
+                                           (faceCounts->size() + faceIndices->size()) * sizeof(int32_t));
+
+    // samples referenced by polygons until triangulated
+    IN3fGeomParam::Sample normals;
+    IV2fGeomParam::Sample texCoords;
+    IC3fGeomParam::Sample colors;
+    readMeshAttribute(schema.getNormalsParam(), iss, 3, polygons, normals, polygons.normals, bytesRead);
+    readMeshAttribute(schema.getUVsParam(), iss, 2, polygons, texCoords, polygons.texCoords, bytesRead);
+    // float32 rgb colors, indexed or not
+    ICompoundProperty cProp = schema.getArbGeomParams();
+    if(cProp)
+    {
+        for(std::size_t i = 0; i < cProp.getNumProperties() && !polygons.colors.values; ++i)
+        {
+            const PropertyHeader& propHeader = cProp.getPropertyHeader(i);
+            if(IC3fGeomParam::matches(propHeader))
+                readMeshAttribute(IC3fGeomParam(cProp, propHeader.getName()), iss, 3, polygons, colors,
+                                  polygons.colors, bytesRead);
+        }
+    }
+
+    checkCancelled();
+    MeshData data = triangulate(polygons);
+    // positions are referenced without copy when no vertex had to be split
+    data.owners.push_back(makeDataOwner(positions));
+
+    const Box3d box = sample.getSelfBounds();
+    if(!box.isEmpty())
+        data.bounds = BoundingBox(QVector3D(box.min.x, box.min.y, box.min.z), QVector3D(box.max.x, box.max.y, box.max.z));
+    if(data.bounds.isEmpty())
+    {
+        float minCorner[3], maxCorner[3];
+        kernels::bounds(reinterpret_cast<const float*>(data.positions.constData()),
+                        static_cast<std::size_t>(data.vertexCount), minCorner, maxCorner);
+        data.bounds = BoundingBox(QVector3D(minCorner[0], minCorner[1], minCorner[2]),
+                                  QVector3D(maxCorner[0], maxCorner[1], maxCorner[2]));
+    }
+
+    if(statistics)
+    {
+        statistics->add(LoadStatistics::Counter::Meshes, 1);
+        statistics->add(LoadStatistics::Counter::Triangles, data.indexCount / 3);
+        statistics->add(LoadStatistics::Counter::BytesRead, bytesRead);
+    }
+    return data;
+}
+
+void SceneReader::decimate(PointCloudData& data, int targetCount)
+{
+    if(targetCount <= 0 || data.npoints <= targetCount || data.bounds.isEmpty())
+        return;
+
+    // voxel grid with about targetCount cells over the bounding box (flat boxes keep a minimum thickness)
+    const QVector3D boxSize = data.bounds.size();
+    const float extent = std::max(std::max(boxSize.x(), boxSize.y()), std::max(boxSize.z(), 1e-6f));
+    float volume = 1.0f;
+    for(int k = 0; k < 3; ++k)
+        volume *= std::max(boxSize[k], extent * 1e-3f);
+    const float cellSize = std::cbrt(volume / static_cast<float>(targetCount));
+    quint64 resolution[3];
+    for(int k = 0; k < 3; ++k)
+        resolution[k] = static_cast<quint64>(std::min(std::max(std::ceil(boxSize[k] / cellSize), 1.0f), 1048576.0f));
+
+    const float* positions = reinterpret_cast<const float*>(data.positions.constData());
+    const QVector3D origin = data.bounds.min();
+    // returns false for points with non-finite coordinates, which are dropped
+    const auto cellKey = [&](int i, quint64& key) -> bool {
+        key = 0;
+        for(int k = 0; k < 3; ++k)
+        {
+            const float p = positions[3 * i + k];
+            if(!std::isfinite(p))
+                return false;
+            const float cell = std::min(std::max((p - origin[k]) / cellSize, 0.0f), static_cast<float>(resolution[k] - 1));
+            key = key * resolution[k] + static_cast<quint64>(cell);
+        }
+        return true;
+    };
+
+    struct Cell
+    {
+        quint32 count = 0;
+        quint32 seen = 0;
+        quint32 quota = 0;
+    };
+    std::unordered_map<quint64, Cell> cells;
+    cells.reserve(static_cast<std::size_t>(targetCount));
+    quint64 key = 0;
+    for(int i = 0; i < data.npoints; ++i)
+    {
+        if(cellKey(i, key))
+            ++cells[key].count;
+    }
+
+    // share the points between cells, capping the densest ones so that the subset is spatially uniform
+    std::vector<Cell*> sortedCells;
+    sortedCells.reserve(cells.size());
+    for(auto& cell : cells)
+        sortedCells.push_back(&cell.second);
+    std::sort(sortedCells.begin(), sortedCells.end(), [](const Cell* a, const Cell* b) { return a->count < b->count; });
+    quint64 remaining = static_cast<quint64>(targetCount);
+    for(std::size_t i = 0; i < sortedCells.size(); ++i)
+    {
+        const quint64 cellsLeft = sortedCells.size() - i;
+        const quint64 share = remaining / cellsLeft;
+        if(sortedCells[i]->count <= share)
+        {
+            sortedCells[i]->quota = sortedCells[i]->count;
+            remaining -= sortedCells[i]->count;
+            continue;
+        }
+        // all the following cells have more points than their share: distribute the remainder too
+        const quint64 extra = remaining % cellsLeft;
+        for(std::size_t j = i; j < sortedCells.size(); ++j)
+            sortedCells[j]->quota = static_cast<quint32>(share + (j - i < extra ? 1 : 0));
+        break;
+    }
+
+    // keep evenly spaced points of each cell, colors following positions
+    const float* colors = reinterpret_cast<const float*>(data.colors.constData());
+    const bool hasColors = data.colors.size() == data.positions.size();
+    QByteArray keptPositions;
+    QByteArray keptColors;
+    keptPositions.reserve(targetCount * 3 * static_cast<int>(sizeof(float)));
+    keptColors.reserve(targetCount * 3 * static_cast<int>(sizeof(float)));
+    int npoints = 0;
+    for(int i = 0; i < data.npoints; ++i)
+    {
+        if(!cellKey(i, key))
+            continue;
+        Cell& cell = cells[key];
+        const quint64 seen = cell.seen++;
+        if((seen + 1) * cell.quota / cell.count == seen * cell.quota / cell.count)
+            continue;
+        keptPositions.append(reinterpret_cast<const char*>(positions + 3 * i), 3 * sizeof(float));
+        if(hasColors)
+            keptColors.append(reinterpret_cast<const char*>(colors + 3 * i), 3 * sizeof(float));
+        ++npoints;
+    }
+
+    data.npoints = npoints;
+    data.positions = keptPositions;
+    data.colors = keptColors;
+    // decimated buffers are owned: release the original samples
+    data.owners.clear();
+}
+
+void SceneReader::buildOctree(PointCloudData& data)
+{
+    std::shared_ptr<PointOctree> octree = std::make_shared<PointOctree>();
+    octree->build(reinterpret_cast<const float*>(data.positions.constData()),
+                  static_cast<std::size_t>(data.npoints), PointOctree::BuildParams());
+
+    // sort points by octree node
+    const auto reorder = [&octree](const QByteArray& input) -> QByteArray {
+        QByteArray output(input.size(), Qt::Uninitialized);
+        const float* src = reinterpret_cast<const float*>(input.constData());
+        float* dst = reinterpret_cast<float*>(output.data());
+        const auto& order = octree->order();
+        for(std::size_t i = 0; i < order.size(); ++i)
+            std::copy(src + 3 * order[i], src + 3 * order[i] + 3, dst + 3 * i);
+        return output;
+    };
+    const int expectedSize = data.npoints * 3 * static_cast<int>(sizeof(float));
+    data.positions = reorder(data.positions);
+    if(data.colors.size() == expectedSize)
+        data.colors = reorder(data.colors);
+    data.octree = octree;
+    // sorted buffers are owned: release the original samples
+    if(data.colors.size() == expectedSize)
+        data.owners.clear();
+}
+
+void SceneReader::computeRadii(PointCloudData& data) const
+{
+    LoadStatistics::Scope scope(_options.statistics.get(), "computeRadii");
+    PointSpacing spacing;
+    spacing.build(reinterpret_cast<const float*>(data.positions.constData()), static_cast<std::size_t>(data.npoints),
+                  8);
+    // points without spacing estimate get a radius of 0, the point size being used instead
+    data.radii = QByteArray(data.npoints * static_cast<int>(sizeof(float)), '\0');
+    float* radii = reinterpret_cast<float*>(data.radii.data());
+    const std::size_t blockSize = 65536;
+    const int blockCount = static_cast<int>((spacing.size() + blockSize - 1) / blockSize);
+    parallelFor(blockCount, _options.threadCount, [&](int block) {
+        checkCancelled();
+        const std::size_t first = static_cast<std::size_t>(block) * blockSize;
+        spacing.estimate(first, std::min(first + blockSize, spacing.size()), radii);
+    });
+    // splats of half the mean distance to the nearest neighbours slightly overlap on regular samplings
+    for(int i = 0; i < data.npoints; ++i)
+        radii[i] *= 0.5f;
+}
+
+void SceneReader::buildPickingTree(PointCloudData& data) const
+{
+    LoadStatistics::Scope scope(_options.statistics.get(), "buildPickingTree");
+    std::shared_ptr<PointKdTree> tree = std::make_shared<PointKdTree>();
+    tree->build(reinterpret_cast<const float*>(data.positions.constData()), static_cast<std::size_t>(data.npoints), 16,
+                [this](int count, const std::function<void(int)>& function) {
+                    parallelFor(count, _options.threadCount, function);
+                });
+    data.pickingTree = tree;
+}
+
+void SceneReader::encodeVertices(PointCloudData& data, VertexFormat format)
+{
+    if(format == VertexFormat::Float || data.format != VertexFormat::Float)
+        return;
+
+    const int expectedSize = data.npoints * 3 * static_cast<int>(sizeof(float));
+    const float* positions = reinterpret_cast<const float*>(data.positions.constData());
+    const float* colors = data.colors.size() == expectedSize ? reinterpret_cast<const float*>(data.colors.constData()) : nullptr;
+
+    if(format == VertexFormat::Quantized)
+    {
+        // quantize positions relatively to the bounding box of the finite positions
+        const QVector3D minCorner = data.bounds.min();
+        const QVector3D maxCorner = data.bounds.max();
+        for(int k = 0; k < 3; ++k)
+        {
+            const bool valid = minCorner[k] <= maxCorner[k];
+            data.quantizationOffset[k] = valid ? minCorner[k] : 0.0f;
+            data.quantizationScale[k] = valid && maxCorner[k] > minCorner[k] ? maxCorner[k] - minCorner[k] : 1.0f;
+        }
+    }
+
+    const int stride = vertexStride(format);
+    const int colorOffset = colorByteOffset(format);
+    QByteArray vertices(data.npoints * stride, '\0');
+
+    // convert colors by blocks to RGB8
+    const int blockSize = 4096;
+    std::vector<quint8> rgb(3 * blockSize, 204);
+    for(int i = 0; i < data.npoints; ++i)
+    {
+        if(colors && i % blockSize == 0)
+        {
+            const int count = std::min(blockSize, data.npoints - i);
+            kernels::floatToUnorm8(colors + 3 * static_cast<std::size_t>(i), rgb.data(), 3 * static_cast<std::size_t>(count));
+        }
+        char* vertex = vertices.data() + static_cast<std::size_t>(i) * stride;
+        const float* p = positions + 3 * i;
+        if(format == VertexFormat::Quantized)
+        {
+            quint16 q[3];
+            for(int k = 0; k < 3; ++k)
+                q[k] = toUnsignedShort((p[k] - data.quantizationOffset[k]) / data.quantizationScale[k]);
+            std::memcpy(vertex, q, sizeof(q));
+        }
+        else
+        {
+            std::memcpy(vertex, p, 3 * sizeof(float));
+        }
+        const quint8* c = rgb.data() + 3 * (i % blockSize);
+        const quint8 rgba[4] = {c[0], c[1], c[2], 255};
+        std::memcpy(vertex + colorOffset, rgba, sizeof(rgba));
+    }
+
+    data.format = format;
+    data.vertices = vertices;
+    data.positions.clear();
+    data.colors.clear();
+    // interleaved vertices are owned: release the original samples
+    data.owners.clear();
+}
+
+} // namespace
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "LoadStatistics.hpp"
+#include "SceneDescription.hpp"
+#include <Alembic/AbcGeom/All.h>
+#include <QHash>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace abcentity
+{
+
+/// Options controlling how an Alembic archive is read.
+struct LoadOptions
+{
+    /// Skip objects with visibility explicitly set to hidden
+    bool skipHidden = false;
+    /// Defer point cloud vertex data, to be streamed in chunks once the hierarchy is available
+    bool streaming = false;
+    /// Number of points per streamed chunk
+    int chunkSize = 1000000;
+    /// Build a level-of-detail octree for each point cloud
+    bool levelOfDetail = false;
+    /// Layout of point cloud vertex buffers
+    VertexFormat vertexFormat = VertexFormat::Float;
+    /// Compute the radius of each point from the spacing of its nearest neighbours (see PointCloudData::radii)
+    bool pointRadii = false;
+    /// Build a k-d tree over each point cloud to pick points (see PointCloudData::pickingTree)
+    bool pickingTree = false;
+    /// Only keep renderable objects, as direct children of the root with their world transform
+    bool flattenHierarchy = false;
+    /// Time at which animated objects are read, in seconds
+    double time = 0.0;
+    /// Maximum number of points loaded, shared between point clouds proportionally to their size (0 for all points)
+    int maxPoints = 0;
+    /// Fraction of the points kept by decimation, derived from maxPoints by SceneReader::read
+    double subsampleRatio = 1.0;
+    /// Read archives from a memory mapping of the file instead of file streams
+    bool memoryMapped = false;
+    /// Number of threads decoding point clouds (and Ogawa streams), 0 for the number of cores
+    int threadCount = 0;
+    /// Only inspect the hierarchy and object headers with SceneInspector, without building a scene
+    bool inspectOnly = false;
+    /// Compute the digest of each point cloud (see SceneNode::digest), for watched archives to be reloaded incrementally
+    bool watch = false;
+    /// Digests of point clouds already loaded, indexed by path: matching point clouds are not read again
+    QHash<QString, QByteArray> previousDigests;
+    /// Key of the archive in ArchiveCache, to share decoded point clouds (empty to disable)
+    QString archiveKey;
+    /// If set, stage timings and counters of the load are recorded
+    std::shared_ptr<LoadStatistics> statistics;
+    /// If set, reading stops with LoadCancelled as soon as it becomes true
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+/// Exception thrown by SceneReader when LoadOptions::cancelled is set
+struct LoadCancelled : public std::exception
+{
+    const char* what() const noexcept override { return "load cancelled"; }
+};
+
+/**
+ * @brief Build a SceneNode tree from an Alembic archive.
+ *
+ * Reads matrices, vertex data and properties of every visited object.
+ * Does not create any QObject and can safely be used from a worker thread.
+ */
+class SceneReader
+{
+public:
+    explicit SceneReader(const LoadOptions& options);
+
+    /// Read the given object and its children, and fill the transform table and animation of the returned root.
+    /// Returns nullptr if the object is skipped.
+    std::unique_ptr<SceneNode> read(const Alembic::Abc::IObject& iObj);
+
+    /// Point clouds whose vertex data has been deferred, indexed by SceneNode::streamIndex.
+    const std::vector<Alembic::AbcGeom::IPoints>& deferredPoints() const { return _deferredPoints; }
+
+    /// Read positions and colors of an IPoints object at the given time, and process them according to the options.
+    PointCloudData readPointCloud(const Alembic::AbcGeom::IPoints& points, double time) const;
+    PointCloudData readPointCloud(const Alembic::AbcGeom::IPoints& points) const { return readPointCloud(points, _options.time); }
+    /// Read and triangulate an IPolyMesh object at the given time, with its normals, texture coordinates and colors.
+    MeshData readMesh(const Alembic::AbcGeom::IPolyMesh& mesh, double time) const;
+    /// Throw LoadCancelled if the load has been cancelled.
+    void checkCancelled() const
+    {
+        if(_options.cancelled && _options.cancelled->load())
+            throw LoadCancelled();
+    }
+
+    /// Number of points kept from a point cloud of npoints points.
+    int subsampledPointCount(int npoints) const;
+
+    /// Read the local matrix of an Xform at the given time.
+    static QMatrix4x4 readMatrix(const Alembic::AbcGeom::IXform& xform, double time);
+    /// Get the number of points of an IPoints object without reading its positions.
+    static int readPointCount(const Alembic::AbcGeom::IPoints& points, double time = 0.0);
+
+private:
+    std::unique_ptr<SceneNode> readNode(const Alembic::Abc::IObject& iObj, const SceneNode* parent);
+    /// Decode the point clouds found by readNode, in parallel
+    void readPendingPoints();
+    /// Decode the meshes found by readNode, in parallel
+    void readPendingMeshes();
+    /// Derive the subsample ratio of all point clouds from LoadOptions::maxPoints
+    void applyPointBudget();
+    /// Register the time-varying data of node
+    void addAnimationTracks(const SceneNode& node, const Alembic::Abc::IObject& iObj);
+    /// Move the renderable objects of the subtree rooted at node to the children of root.
+    static void flatten(std::unique_ptr<SceneNode> node, SceneNode& root);
+    /// Keep a spatially uniform subset of targetCount points, with at most a few points per cell of a voxel grid.
+    static void decimate(PointCloudData& data, int targetCount);
+    /// Build the level-of-detail octree of data and sort its points accordingly.
+    static void buildOctree(PointCloudData& data);
+    /// Convert Float vertex data to an interleaved format.
+    static void encodeVertices(PointCloudData& data, VertexFormat format);
+    /// Compute the radius of each point of Float vertex data, in parallel.
+    void computeRadii(PointCloudData& data) const;
+    /// Build the picking tree over the Float positions of data, in parallel.
+    void buildPickingTree(PointCloudData& data) const;
+
+    bool isHidden(const Alembic::Abc::IObject& iObj) const;
+
+private:
+    LoadOptions _options;
+    TransformTable _transforms;
+    std::shared_ptr<SceneAnimation> _animation;
+    /// Xforms from the root to the object being read, and how many of them are animated
+    std::vector<Alembic::AbcGeom::IXform> _xformStack;
+    int _animatedXformCount = 0;
+    std::vector<Alembic::AbcGeom::IPoints> _deferredPoints;
+    std::vector<std::pair<SceneNode*, Alembic::AbcGeom::IPoints>> _pendingPoints;
+    std::vector<std::pair<SceneNode*, Alembic::AbcGeom::IPolyMesh>> _pendingMeshes;
+    /// Point cloud nodes whose vertex data is not read by read(): streamed or unchanged
+    std::vector<SceneNode*> _undecodedNodes;
+};
+
+} // namespace
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "AlembicEntity.hpp"
+#include "AlembicInspector.hpp"
+#include "AlembicSceneGroup.hpp"
+#include "CameraBatchEntity.hpp"
+#include "CameraLocatorEntity.hpp"
+#include "MeshEntity.hpp"
+#include "PointCloudEntity.hpp"
 #include <QtQml>
 #include <QQmlExtensionPlugin>
 
@@ -17,11 +23,18 @@ public:
     void registerTypes(const char* uri) override
     {
         Q_ASSERT(uri == QLatin1String("AlembicEntity"));
+        qRegisterMetaType<BoundingBox>();
         qmlRegisterType<AlembicEntity>(uri, 2, 0, "AlembicEntity");
+        qmlRegisterType<AlembicSceneGroup>(uri, 2, 0, "AlembicSceneGroup");
+        qmlRegisterType<AlembicInspector>(uri, 2, 0, "AlembicInspector");
         qmlRegisterUncreatableType<CameraLocatorEntity>(uri, 2, 0, "CameraLocatorEntity",
                                                         "Cannot create CameraLocatorEntity instances from QML.");
+        qmlRegisterUncreatableType<CameraBatchEntity>(uri, 2, 0, "CameraBatchEntity",
+                                                        "Cannot create CameraBatchEntity instances from QML.");
         qmlRegisterUncreatableType<PointCloudEntity>(uri, 2, 0, "PointCloudEntity",
                                                         "Cannot create PointCloudEntity instances from QML.");
+        qmlRegisterUncreatableType<MeshEntity>(uri, 2, 0, "MeshEntity",
+                                                        "Cannot create MeshEntity instances from QML.");
     }
 };
 
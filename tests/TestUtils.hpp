@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/// Report a failed condition and exit with an error code
+#define CHECK(condition)                                                                                    \
+    do                                                                                                      \
+    {                                                                                                       \
+        if(!(condition))                                                                                    \
+        {                                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl;        \
+            std::exit(EXIT_FAILURE);                                                                        \
+        }                                                                                                   \
+    } while(false)
+
+namespace abcentity
+{
+namespace test
+{
+
+/// XYZ positions of npoints uniformly distributed in the cube [-size, size]^3
+inline std::vector<float> randomPositions(std::size_t npoints, float size, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-size, size);
+    std::vector<float> positions(3 * npoints);
+    for(float& value : positions)
+        value = distribution(generator);
+    return positions;
+}
+
+} // namespace
+} // namespace
@@ -0,0 +1,162 @@
+#include "PointKdTree.hpp"
+#include "TestUtils.hpp"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+using namespace abcentity;
+
+namespace
+{
+
+/// Run function concurrently on a few threads, indices being taken in turn
+void threadedFor(int count, const std::function<void(int)>& function)
+{
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            for(int i = next++; i < count; i = next++)
+                function(i);
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+}
+
+/// Distance along the ray of a point closer than radius to it, negative otherwise
+float rayDistance(const float* p, const float origin[3], const float direction[3], float radius)
+{
+    if(!std::isfinite(p[0]) || !std::isfinite(p[1]) || !std::isfinite(p[2]))
+        return -1.0f;
+    const float v[3] = {p[0] - origin[0], p[1] - origin[1], p[2] - origin[2]};
+    const float t = v[0] * direction[0] + v[1] * direction[1] + v[2] * direction[2];
+    const float distanceSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2] - t * t;
+    return t >= 0.0f && distanceSquared <= radius * radius ? t : -1.0f;
+}
+
+/// Distance along the ray of the first point closer than radius to it, negative if none
+float bruteForcePick(const std::vector<float>& positions, const float origin[3], const float direction[3], float radius)
+{
+    float closest = -1.0f;
+    for(std::size_t i = 0; i < positions.size() / 3; ++i)
+    {
+        const float t = rayDistance(positions.data() + 3 * i, origin, direction, radius);
+        if(t >= 0.0f && (closest < 0.0f || t < closest))
+            closest = t;
+    }
+    return closest;
+}
+
+/// Compare the picks of a tree with brute force picks, for random rays through the cloud
+void checkPicks(const PointKdTree& tree, const std::vector<float>& positions, float size, float radius, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    int pickedCount = 0;
+    for(int r = 0; r < 200; ++r)
+    {
+        // rays from outside the cloud toward a random point of it, some of them axis-aligned
+        float target[3], direction[3];
+        for(int k = 0; k < 3; ++k)
+            target[k] = 0.8f * size * distribution(generator);
+        if(r % 10 == 0)
+        {
+            direction[0] = direction[1] = direction[2] = 0.0f;
+            direction[r / 10 % 3] = 1.0f;
+        }
+        else
+        {
+            for(int k = 0; k < 3; ++k)
+                direction[k] = distribution(generator);
+        }
+        const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                       direction[2] * direction[2]);
+        if(length < 1e-3f)
+            continue;
+        float origin[3];
+        for(int k = 0; k < 3; ++k)
+        {
+            direction[k] /= length;
+            origin[k] = target[k] - 3.0f * size * direction[k];
+        }
+
+        float distance = 0.0f;
+        const int64_t picked = tree.pick(origin, direction, radius, &distance);
+        const float expected = bruteForcePick(positions, origin, direction, radius);
+        CHECK((picked >= 0) == (expected >= 0.0f));
+        if(picked < 0)
+            continue;
+        ++pickedCount;
+        CHECK(static_cast<std::size_t>(picked) < positions.size() / 3);
+        const float t = rayDistance(positions.data() + 3 * picked, origin, direction, radius);
+        CHECK(t >= 0.0f && std::abs(t - distance) <= 1e-4f * size);
+        CHECK(std::abs(distance - expected) <= 1e-4f * size);
+    }
+    CHECK(pickedCount > 0);
+}
+
+void testPicking()
+{
+    const float size = 10.0f;
+    std::vector<float> positions = test::randomPositions(50000, size, 1);
+    // non-finite points are never picked
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for(std::size_t i = 0; i < positions.size(); i += 999)
+        positions[i] = nan;
+
+    for(uint32_t leafSize : {1u, 16u, 100000u})
+    {
+        PointKdTree tree;
+        tree.build(positions.data(), positions.size() / 3, leafSize);
+        CHECK(!tree.empty());
+        checkPicks(tree, positions, size, 0.1f, leafSize);
+
+        // subtrees built concurrently are appended to the node array
+        PointKdTree parallelTree;
+        parallelTree.build(positions.data(), positions.size() / 3, leafSize, threadedFor);
+        CHECK(parallelTree.byteSize() == tree.byteSize());
+        checkPicks(parallelTree, positions, size, 0.1f, leafSize);
+    }
+}
+
+void testDegenerateInput()
+{
+    const float origin[3] = {0.0f, 0.0f, -10.0f};
+    const float direction[3] = {0.0f, 0.0f, 1.0f};
+
+    PointKdTree empty;
+    empty.build(nullptr, 0, 16, threadedFor);
+    CHECK(empty.empty() && empty.pick(origin, direction, 1.0f) < 0);
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const std::vector<float> nans(3 * 100, nan);
+    PointKdTree nanTree;
+    nanTree.build(nans.data(), nans.size() / 3, 16, threadedFor);
+    CHECK(nanTree.empty() && nanTree.pick(origin, direction, 1.0f) < 0);
+
+    // coincident points: the first one along the ray is any of them
+    std::vector<float> coincident;
+    for(int i = 0; i < 1000; ++i)
+        coincident.insert(coincident.end(), {0.0f, 0.0f, 1.0f});
+    coincident.insert(coincident.end(), {0.0f, 0.5f, 0.5f});
+    PointKdTree coincidentTree;
+    coincidentTree.build(coincident.data(), coincident.size() / 3, 16, threadedFor);
+    float distance = 0.0f;
+    CHECK(coincidentTree.pick(origin, direction, 0.1f, &distance) >= 0 && std::abs(distance - 11.0f) < 1e-5f);
+    CHECK(coincidentTree.pick(origin, direction, 1.0f, &distance) == 1000 && std::abs(distance - 10.5f) < 1e-5f);
+    // points behind the ray origin are not picked
+    const float behind[3] = {0.0f, 0.0f, 2.0f};
+    CHECK(coincidentTree.pick(behind, direction, 1.0f) < 0);
+}
+
+} // namespace
+
+int main()
+{
+    testPicking();
+    testDegenerateInput();
+    return EXIT_SUCCESS;
+}
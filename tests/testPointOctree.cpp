@@ -0,0 +1,215 @@
+#include "PointOctree.hpp"
+#include "TestUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace abcentity;
+
+namespace
+{
+
+/// Check the structure of an octree built over positions and return the index of the parent of each node
+std::vector<int> checkStructure(const PointOctree& octree, const std::vector<float>& positions,
+                                const PointOctree::BuildParams& params)
+{
+    const std::size_t npoints = positions.size() / 3;
+    const auto& nodes = octree.nodes();
+    CHECK(octree.order().size() == npoints);
+    CHECK(nodes.empty() == (npoints == 0));
+
+    // reordering is a permutation
+    std::vector<uint32_t> order = octree.order();
+    std::sort(order.begin(), order.end());
+    for(std::size_t i = 0; i < order.size(); ++i)
+        CHECK(order[i] == i);
+
+    // node ranges are disjoint and cover all the points
+    std::vector<int> parents(nodes.size(), -1);
+    std::vector<int> owner(npoints, -1);
+    for(std::size_t n = 0; n < nodes.size(); ++n)
+    {
+        const PointOctree::Node& node = nodes[n];
+        CHECK(node.count > 0 || n == 0);
+        CHECK(node.depth <= params.maxDepth);
+        bool isLeaf = true;
+        for(int o = 0; o < 8; ++o)
+        {
+            const int32_t child = node.children[o];
+            if(child < 0)
+                continue;
+            isLeaf = false;
+            CHECK(child > static_cast<int32_t>(n) && child < static_cast<int32_t>(nodes.size()));
+            CHECK(parents[child] < 0);
+            parents[child] = static_cast<int>(n);
+            CHECK(nodes[child].depth == node.depth + 1);
+            CHECK(nodes[child].halfSize == 0.5f * node.halfSize);
+        }
+        // subsampled nodes keep at most one point per cell of a grid of nodeCapacity cells
+        CHECK(node.count <= params.nodeCapacity || (isLeaf && node.depth == params.maxDepth));
+        for(uint32_t i = node.first; i < node.first + node.count; ++i)
+        {
+            CHECK(i < npoints && owner[i] < 0);
+            owner[i] = static_cast<int>(n);
+            // finite points lie in their node cube
+            const float* p = positions.data() + 3 * octree.order()[i];
+            for(int k = 0; k < 3; ++k)
+            {
+                if(std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2]))
+                    CHECK(std::abs(p[k] - node.center[k]) <= node.halfSize * 1.0001f + 1e-6f);
+            }
+        }
+    }
+    for(int n : owner)
+        CHECK(n >= 0);
+    for(std::size_t n = 1; n < nodes.size(); ++n)
+        CHECK(parents[n] >= 0);
+    return parents;
+}
+
+/// Check that each selected node follows its parent and return the number of selected points
+std::size_t checkSelection(const PointOctree& octree, const std::vector<int>& parents, const std::vector<int>& selected)
+{
+    std::vector<bool> isSelected(octree.nodes().size(), false);
+    std::size_t total = 0;
+    for(int index : selected)
+    {
+        CHECK(index >= 0 && index < static_cast<int>(isSelected.size()) && !isSelected[index]);
+        CHECK(index == 0 || isSelected[parents[index]]);
+        isSelected[index] = true;
+        total += octree.nodes()[index].count;
+    }
+    return total;
+}
+
+void testSubdivision()
+{
+    const std::vector<float> positions = test::randomPositions(200000, 10.0f, 1);
+    PointOctree::BuildParams params;
+    params.nodeCapacity = 1000;
+    PointOctree octree;
+    octree.build(positions.data(), positions.size() / 3, params);
+    checkStructure(octree, positions, params);
+    CHECK(octree.nodes().size() > 8);
+    CHECK(octree.nodes()[0].count <= params.nodeCapacity);
+
+    // a cloud smaller than a node is a single node
+    PointOctree small;
+    small.build(positions.data(), params.nodeCapacity, params);
+    CHECK(small.nodes().size() == 1 && small.nodes()[0].count == params.nodeCapacity);
+}
+
+void testSelection()
+{
+    const std::vector<float> positions = test::randomPositions(100000, 10.0f, 2);
+    const std::size_t npoints = positions.size() / 3;
+    PointOctree::BuildParams buildParams;
+    buildParams.nodeCapacity = 1000;
+    PointOctree octree;
+    octree.build(positions.data(), npoints, buildParams);
+    const std::vector<int> parents = checkStructure(octree, positions, buildParams);
+    const std::size_t rootCount = octree.nodes()[0].count;
+
+    PointOctree::SelectParams params;
+    std::size_t selectedCount = 0;
+
+    // no budget: all nodes
+    std::vector<int> selected = octree.select(params, &selectedCount);
+    CHECK(selected.size() == octree.nodes().size());
+    CHECK(selectedCount == npoints && checkSelection(octree, parents, selected) == npoints);
+
+    // budget smaller than the root: the root is kept
+    params.pointBudget = 1;
+    selected = octree.select(params, &selectedCount);
+    CHECK(selected.size() == 1 && selected[0] == 0 && selectedCount == rootCount);
+
+    // budget larger than the cloud
+    params.pointBudget = 10 * npoints;
+    CHECK(octree.select(params).size() == octree.nodes().size());
+
+    // budgets in between, breadth first and by projected size from an eye
+    const float eye[3] = {0.0f, 0.0f, 30.0f};
+    for(const float* selectEye : {static_cast<const float*>(nullptr), eye})
+    {
+        params.eye = selectEye;
+        std::size_t previousCount = 0;
+        for(std::size_t budget = rootCount; budget < npoints; budget += npoints / 7)
+        {
+            params.pointBudget = budget;
+            selected = octree.select(params, &selectedCount);
+            CHECK(checkSelection(octree, parents, selected) == selectedCount);
+            CHECK(selectedCount <= budget && selectedCount >= previousCount);
+            previousCount = selectedCount;
+        }
+    }
+
+    // frustum culling: nodes outside the half-space x <= -5 are skipped, the root is culled if outside
+    float planes[24];
+    for(int i = 0; i < 6; ++i)
+    {
+        const float plane[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        std::copy(plane, plane + 4, planes + 4 * i);
+    }
+    const float leftPlane[4] = {-1.0f, 0.0f, 0.0f, -5.0f};
+    std::copy(leftPlane, leftPlane + 4, planes);
+    params.eye = nullptr;
+    params.frustumPlanes = planes;
+    params.pointBudget = 0;
+    selected = octree.select(params);
+    CHECK(!selected.empty() && selected.size() < octree.nodes().size());
+    checkSelection(octree, parents, selected);
+    const float outsidePlane[4] = {1.0f, 0.0f, 0.0f, -100.0f};
+    std::copy(outsidePlane, outsidePlane + 4, planes);
+    CHECK(octree.select(params).empty());
+}
+
+void testDegenerateInput()
+{
+    PointOctree::BuildParams params;
+    params.nodeCapacity = 100;
+    params.maxDepth = 8;
+
+    // empty cloud
+    PointOctree empty;
+    empty.build(nullptr, 0, params);
+    CHECK(empty.nodes().empty() && empty.order().empty());
+    CHECK(empty.select(PointOctree::SelectParams()).empty());
+
+    // coincident points are split down to the maximum depth
+    std::vector<float> coincident;
+    for(int i = 0; i < 10000; ++i)
+        coincident.insert(coincident.end(), {1.0f, 2.0f, 3.0f});
+    PointOctree coincidentOctree;
+    coincidentOctree.build(coincident.data(), coincident.size() / 3, params);
+    checkStructure(coincidentOctree, coincident, params);
+    std::size_t selectedCount = 0;
+    coincidentOctree.select(PointOctree::SelectParams(), &selectedCount);
+    CHECK(selectedCount == coincident.size() / 3);
+
+    // NaN and infinite points among finite ones, and without finite points
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> positions = test::randomPositions(5000, 1.0f, 3);
+    for(std::size_t i = 0; i < positions.size(); i += 30)
+        positions[i] = (i % 60 == 0) ? nan : inf;
+    PointOctree mixed;
+    mixed.build(positions.data(), positions.size() / 3, params);
+    checkStructure(mixed, positions, params);
+    mixed.select(PointOctree::SelectParams(), &selectedCount);
+    CHECK(selectedCount == positions.size() / 3);
+
+    std::vector<float> nans(3 * 500, nan);
+    PointOctree nanOctree;
+    nanOctree.build(nans.data(), nans.size() / 3, params);
+    checkStructure(nanOctree, nans, params);
+}
+
+} // namespace
+
+int main()
+{
+    testSubdivision();
+    testSelection();
+    testDegenerateInput();
+    return EXIT_SUCCESS;
+}
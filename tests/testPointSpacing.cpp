@@ -0,0 +1,96 @@
+#include "PointSpacing.hpp"
+#include "TestUtils.hpp"
+#include <cmath>
+#include <limits>
+
+using namespace abcentity;
+
+namespace
+{
+
+/// Spacing of all the points, initialized to NaN to detect points that are not written
+std::vector<float> estimateAll(const std::vector<float>& positions, int neighbourCount = 8)
+{
+    PointSpacing spacing;
+    const std::size_t npoints = positions.size() / 3;
+    spacing.build(positions.data(), npoints, neighbourCount);
+    CHECK(spacing.size() == npoints);
+    std::vector<float> result(npoints, std::numeric_limits<float>::quiet_NaN());
+    spacing.estimate(0, spacing.size(), result.data());
+    return result;
+}
+
+void testEmpty()
+{
+    CHECK(estimateAll(std::vector<float>()).empty());
+}
+
+void testSinglePoint()
+{
+    const std::vector<float> spacing = estimateAll({1.0f, 2.0f, 3.0f});
+    CHECK(spacing.size() == 1 && spacing[0] == 0.0f);
+}
+
+void testCoincidentPoints()
+{
+    std::vector<float> positions;
+    for(int i = 0; i < 100; ++i)
+        positions.insert(positions.end(), {1.0f, 2.0f, 3.0f});
+    for(float value : estimateAll(positions))
+        CHECK(value == 0.0f);
+}
+
+void testNonFinitePoints()
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    // no finite point
+    for(float value : estimateAll({nan, 0.0f, 0.0f, inf, 1.0f, 1.0f}))
+        CHECK(value == 0.0f);
+    // a single finite point
+    for(float value : estimateAll({nan, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f}))
+        CHECK(value == 0.0f);
+
+    // non-finite points among a grid
+    std::vector<float> positions;
+    for(int y = 0; y < 20; ++y)
+    {
+        for(int x = 0; x < 20; ++x)
+            positions.insert(positions.end(), {static_cast<float>(x), static_cast<float>(y), 0.0f});
+    }
+    positions.insert(positions.end(), {nan, nan, nan});
+    const std::vector<float> spacing = estimateAll(positions);
+    CHECK(spacing.back() == 0.0f);
+    for(std::size_t i = 0; i + 1 < spacing.size(); ++i)
+        CHECK(spacing[i] > 0.0f && std::isfinite(spacing[i]));
+}
+
+void testRegularGrid()
+{
+    // 8 nearest neighbours inside a plane grid of unit step: 4 at distance 1 and 4 at distance sqrt(2)
+    std::vector<float> positions;
+    for(int y = 0; y < 50; ++y)
+    {
+        for(int x = 0; x < 50; ++x)
+            positions.insert(positions.end(), {static_cast<float>(x), static_cast<float>(y), 0.0f});
+    }
+    const std::vector<float> spacing = estimateAll(positions);
+    const float expected = (4.0f + 4.0f * std::sqrt(2.0f)) / 8.0f;
+    for(int y = 1; y < 49; ++y)
+    {
+        for(int x = 1; x < 49; ++x)
+            CHECK(std::abs(spacing[static_cast<std::size_t>(y * 50 + x)] - expected) < 1e-4f);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    testEmpty();
+    testSinglePoint();
+    testCoincidentPoints();
+    testNonFinitePoints();
+    testRegularGrid();
+    return EXIT_SUCCESS;
+}